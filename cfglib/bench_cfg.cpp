@@ -0,0 +1,329 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "cfg_graph.h"
+#include "dominators.h"
+#include "loops.h"
+
+// Times graph construction, dominators, frontiers, phi placement and the
+// loop forest on synthetic CFGs.
+// Usage: bench_cfg [-n BLOCKS] [-s SEED] [-check] [random|diamonds|nested]...
+//   random    a chain with random forward jumps and back edges (some
+//             irreducible)
+//   diamonds  if/else diamonds in sequence, a dominator tree BLOCKS/3 deep
+//   nested    loop nests 100 deep in sequence
+// -check compares the idoms with the iterative algorithm, and dominance,
+// frontiers, iterated frontiers and loops with brute force definitions on
+// small random graphs.
+
+typedef std::chrono::steady_clock bench_clock;
+
+static double ms_since(bench_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(bench_clock::now() - start).count();
+}
+
+static cfg_graph_builder random_graph(int n, std::mt19937 &rng) {
+    cfg_graph_builder b(n);
+    b.reserve_edges(n * 1.5);
+    for (int i = 0; i + 1 < n; ++i) {
+        b.add_edge(i, i + 1);
+        unsigned int r = rng() % 100;
+        if (r < 30) {
+            b.add_edge(i, std::min(n - 1, i + 2 + (int) (rng() % 20)));
+        } else if (r < 40) {
+            b.add_edge(i, std::max(0, i - 1 - (int) (rng() % 50)));
+        }
+    }
+    return b;
+}
+
+// Diamonds in sequence: the dominator tree is a path of n/3 blocks.
+static cfg_graph_builder diamond_graph(int n) {
+    cfg_graph_builder b(n);
+    b.reserve_edges(n * 1.4);
+    int i = 0;
+    for (; i + 3 < n; i += 3) {
+        b.add_edge(i, i + 1);
+        b.add_edge(i, i + 2);
+        b.add_edge(i + 1, i + 3);
+        b.add_edge(i + 2, i + 3);
+    }
+    for (; i + 1 < n; ++i) {
+        b.add_edge(i, i + 1);
+    }
+    return b;
+}
+
+// Loop nests of the given depth in sequence. Frontiers of a nest grow
+// quadratically with its depth, so the nests are kept bounded.
+static cfg_graph_builder nested_graph(int n, int depth) {
+    cfg_graph_builder b(n);
+    b.reserve_edges(n * 1.5);
+    for (int i = 0; i + 1 < n; ++i) {
+        b.add_edge(i, i + 1);
+    }
+    int nest = 2 * depth + 2;
+    for (int start = 0; start + nest <= n; start += nest) {
+        for (int d = 1; d <= depth; ++d) {
+            b.add_edge(start + nest - 1 - d, start + d);
+        }
+    }
+    return b;
+}
+
+// Blocks reachable from the entry without passing `removed` (-1 for none).
+static std::vector<char> reachable_without(const cfg_graph &graph, int removed) {
+    std::vector<char> seen(graph.num_blocks(), 0);
+    std::vector<int> stack;
+    if (graph.get_entry() != removed) {
+        stack.push_back(graph.get_entry());
+    }
+    while (!stack.empty()) {
+        int b = stack.back();
+        stack.pop_back();
+        if (seen[b]) {
+            continue;
+        }
+        seen[b] = 1;
+        for (const int *s = graph.succs_begin(b); s != graph.succs_end(b); ++s) {
+            if (*s != removed) {
+                stack.push_back(*s);
+            }
+        }
+    }
+    return seen;
+}
+
+// Checks one graph against the definitions: a dominates b iff b is not
+// reachable without a; y is in DF(x) iff x dominates a predecessor of y
+// but does not strictly dominate y; DF+ is the fixpoint of DF over the
+// union; the loop of header h holds h and every reachable block that
+// reaches a back edge source of h without passing h.
+static bool check_graph(const cfg_graph &graph, std::mt19937 &rng) {
+    int n = graph.num_blocks();
+    dominator_tree dom(graph);
+    dominance_frontiers df(graph, dom);
+    loop_forest loops(graph, dom);
+
+    std::vector<char> reachable = reachable_without(graph, -1);
+    std::vector<std::vector<char>> dominates(n, std::vector<char>(n, 0));
+    for (int a = 0; a < n; ++a) {
+        if (!reachable[a]) {
+            continue;
+        }
+        std::vector<char> without = reachable_without(graph, a);
+        for (int b = 0; b < n; ++b) {
+            dominates[a][b] = reachable[b] && (a == b || !without[b]);
+            if ((bool) dominates[a][b] != dom.dominates(a, b)) {
+                printf("dominates(%d, %d) is %d, expected %d\n", a, b, dom.dominates(a, b), dominates[a][b]);
+                return false;
+            }
+        }
+    }
+
+    std::vector<std::set<int>> frontiers(n);
+    for (int x = 0; x < n; ++x) {
+        for (int y = 0; y < n; ++y) {
+            for (const int *p = graph.preds_begin(y); p != graph.preds_end(y); ++p) {
+                if (dominates[x][*p] && !(dominates[x][y] && x != y)) {
+                    frontiers[x].insert(y);
+                }
+            }
+        }
+        if (df.size(x) != (int) frontiers[x].size()
+            || std::set<int>(df.begin(x), df.end(x)) != frontiers[x]) {
+            printf("frontier of %d differs\n", x);
+            return false;
+        }
+    }
+
+    for (int v = 0; v < 5; ++v) {
+        std::vector<int> defs;
+        for (int d = 0, count = 1 + rng() % 3; d < count; ++d) {
+            defs.push_back(rng() % n);
+        }
+        std::set<int> expected;
+        std::vector<int> work = defs;
+        while (!work.empty()) {
+            int b = work.back();
+            work.pop_back();
+            for (int y : frontiers[b]) {
+                if (expected.insert(y).second) {
+                    work.push_back(y);
+                }
+            }
+        }
+        if (df.iterated(defs) != std::vector<int>(expected.begin(), expected.end())) {
+            printf("iterated frontier of %zu definitions differs\n", defs.size());
+            return false;
+        }
+    }
+
+    int headers = 0;
+    for (int h = 0; h < n; ++h) {
+        std::vector<char> body(n, 0);
+        std::vector<int> stack;
+        for (const int *p = graph.preds_begin(h); p != graph.preds_end(h); ++p) {
+            if (dominates[h][*p]) {
+                stack.push_back(*p);
+            }
+        }
+        if (stack.empty()) {
+            continue;
+        }
+        headers++;
+        body[h] = 1;
+        while (!stack.empty()) {
+            int b = stack.back();
+            stack.pop_back();
+            if (body[b] || !reachable[b]) {
+                continue;
+            }
+            body[b] = 1;
+            for (const int *p = graph.preds_begin(b); p != graph.preds_end(b); ++p) {
+                stack.push_back(*p);
+            }
+        }
+        int loop = loops.is_header(h) ? loops.loop_of(h) : -1;
+        if (loop < 0) {
+            printf("block %d is not a loop header\n", h);
+            return false;
+        }
+        for (int b = 0; b < n; ++b) {
+            int l = loops.loop_of(b);
+            while (l >= 0 && l != loop) {
+                l = loops.get_parent(l);
+            }
+            if ((l == loop) != (bool) body[b]) {
+                printf("block %d %s loop of header %d\n", b, body[b] ? "missing from" : "wrongly in", h);
+                return false;
+            }
+        }
+    }
+    if (headers != loops.num_loops()) {
+        printf("%d loops, expected %d\n", loops.num_loops(), headers);
+        return false;
+    }
+    return true;
+}
+
+// Random graphs of 2..41 blocks with about two edges per block, including
+// self loops, duplicate edges, unreachable blocks and irreducible cycles.
+static bool check_small_graphs(unsigned int seed, int count) {
+    std::mt19937 rng(seed);
+    for (int i = 0; i < count; ++i) {
+        int n = 2 + rng() % 40;
+        cfg_graph_builder b(n);
+        for (int e = 0; e < 2 * n; ++e) {
+            int src = rng() % n;
+            b.add_edge(src, rng() % n);
+        }
+        if (!check_graph(b.build(0), rng)) {
+            printf("small graph %d of seed %u fails\n", i, seed);
+            return false;
+        }
+    }
+    printf("dominance, frontiers, iterated frontiers and loops match brute force on %d small graphs\n", count);
+    return true;
+}
+
+static bool run(const char *kind, int n, unsigned int seed, bool check) {
+    std::mt19937 rng(seed);
+    cfg_graph_builder builder = !strcmp(kind, "nested") ? nested_graph(n, 100)
+                              : !strcmp(kind, "diamonds") ? diamond_graph(n)
+                              : random_graph(n, rng);
+
+    bench_clock::time_point start = bench_clock::now();
+    cfg_graph graph = builder.build(0);
+    double build_ms = ms_since(start);
+
+    start = bench_clock::now();
+    dominator_tree dom(graph);
+    double dom_ms = ms_since(start);
+
+    start = bench_clock::now();
+    dominance_frontiers df(graph, dom);
+    double df_ms = ms_since(start);
+
+    // Phi placement for 100 variables with 10 random definitions each.
+    start = bench_clock::now();
+    size_t phis = 0;
+    for (int v = 0; v < 100; ++v) {
+        std::vector<int> defs;
+        for (int d = 0; d < 10; ++d) {
+            defs.push_back(rng() % n);
+        }
+        phis += df.iterated(defs).size();
+    }
+    double idf_ms = ms_since(start);
+
+    start = bench_clock::now();
+    loop_forest loops(graph, dom);
+    double loops_ms = ms_since(start);
+
+    int max_depth = 0;
+    for (int l = 0; l < loops.num_loops(); ++l) {
+        max_depth = std::max(max_depth, loops.get_depth(l));
+    }
+    printf("%-8s blocks %d edges %d | build %.1f ms  dominators %.1f ms  frontiers %.1f ms  "
+           "idf x100 %.1f ms (%zu phis)  loops %.1f ms (%d loops, depth %d)\n",
+           kind, graph.num_blocks(), graph.num_edges(), build_ms, dom_ms, df_ms, idf_ms, phis, loops_ms,
+           loops.num_loops(), max_depth);
+
+    if (check) {
+        start = bench_clock::now();
+        std::vector<int> expected = iterative_idoms(graph);
+        double chk_ms = ms_since(start);
+        for (int b = 0; b < graph.num_blocks(); ++b) {
+            if (expected[b] != dom.get_idom(b)) {
+                printf("%-8s idom mismatch at block %d: %d, iterative %d\n", kind, b, dom.get_idom(b), expected[b]);
+                return false;
+            }
+        }
+        printf("%-8s idoms match the iterative algorithm (%.1f ms)\n", kind, chk_ms);
+    }
+    return true;
+}
+
+int main(int argc, char **argv) {
+    int n = 1000000;
+    unsigned int seed = 1;
+    bool check = false;
+    std::vector<std::string> kinds;
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "-n") && i + 1 < argc) {
+            n = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "-s") && i + 1 < argc) {
+            seed = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "-check")) {
+            check = true;
+        } else if (!strcmp(argv[i], "random") || !strcmp(argv[i], "diamonds") || !strcmp(argv[i], "nested")) {
+            kinds.push_back(argv[i]);
+        } else {
+            fprintf(stderr, "usage: %s [-n BLOCKS] [-s SEED] [-check] [random|diamonds|nested]...\n", argv[0]);
+            return 2;
+        }
+    }
+    if (n < 2) {
+        fprintf(stderr, "need at least 2 blocks\n");
+        return 2;
+    }
+    if (kinds.empty()) {
+        kinds = {"random", "diamonds", "nested"};
+    }
+    if (check && !check_small_graphs(seed, 300)) {
+        return 1;
+    }
+    for (const std::string &kind : kinds) {
+        if (!run(kind.c_str(), n, seed, check)) {
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,41 @@
+#include <algorithm>
+
+#include "cfg_graph.h"
+
+void cfg_graph_builder::add_edge(int src, int dest) {
+    this->blocks = std::max(this->blocks, std::max(src, dest) + 1);
+    this->from.push_back(src);
+    this->to.push_back(dest);
+}
+
+void cfg_graph_builder::reserve_edges(size_t count) {
+    this->from.reserve(count);
+    this->to.reserve(count);
+}
+
+// offsets[b + 1] counts keys equal to b, then becomes a prefix sum; list
+// is filled in stable order.
+static void layout(int blocks, const std::vector<int> &keys, const std::vector<int> &values,
+                   std::vector<int> &offsets, std::vector<int> &list) {
+    offsets.assign(blocks + 1, 0);
+    for (int key : keys) {
+        offsets[key + 1]++;
+    }
+    for (int b = 0; b < blocks; ++b) {
+        offsets[b + 1] += offsets[b];
+    }
+    list.resize(keys.size());
+    std::vector<int> next(offsets.begin(), offsets.end() - 1);
+    for (size_t i = 0; i < keys.size(); ++i) {
+        list[next[keys[i]]++] = values[i];
+    }
+}
+
+cfg_graph cfg_graph_builder::build(int entry) const {
+    cfg_graph g;
+    int blocks = std::max(this->blocks, entry + 1);
+    g.entry = entry;
+    layout(blocks, this->from, this->to, g.succ_offsets, g.succ_list);
+    layout(blocks, this->to, this->from, g.pred_offsets, g.pred_list);
+    return g;
+}
@@ -0,0 +1,55 @@
+#ifndef CFG_GRAPH_H
+#define CFG_GRAPH_H
+
+#include <cstddef>
+#include <vector>
+
+// Immutable control flow graph in compressed sparse row form. Blocks are
+// dense ids 0..num_blocks()-1; the successors of b are
+// succs[succ_offsets[b] .. succ_offsets[b + 1]), predecessors likewise.
+// Ids that no edge touches are simply unreachable.
+class cfg_graph {
+private:
+    int entry;
+    std::vector<int> succ_offsets;
+    std::vector<int> succ_list;
+    std::vector<int> pred_offsets;
+    std::vector<int> pred_list;
+
+    friend class cfg_graph_builder;
+
+public:
+    cfg_graph() : entry(0), succ_offsets(1, 0), pred_offsets(1, 0) {}
+
+    int num_blocks() const { return (int) this->succ_offsets.size() - 1; }
+    int num_edges() const { return (int) this->succ_list.size(); }
+    int get_entry() const { return this->entry; }
+
+    const int *succs_begin(int b) const { return this->succ_list.data() + this->succ_offsets[b]; }
+    const int *succs_end(int b) const { return this->succ_list.data() + this->succ_offsets[b + 1]; }
+    const int *preds_begin(int b) const { return this->pred_list.data() + this->pred_offsets[b]; }
+    const int *preds_end(int b) const { return this->pred_list.data() + this->pred_offsets[b + 1]; }
+    int num_succs(int b) const { return this->succ_offsets[b + 1] - this->succ_offsets[b]; }
+    int num_preds(int b) const { return this->pred_offsets[b + 1] - this->pred_offsets[b]; }
+};
+
+// Collects edges, then lays them out with a counting sort. Successor order
+// is insertion order; duplicate edges are kept.
+class cfg_graph_builder {
+private:
+    int blocks;
+    std::vector<int> from;
+    std::vector<int> to;
+
+public:
+    cfg_graph_builder(int num_blocks = 0) : blocks(num_blocks) {}
+
+    // Adds a block and returns its id.
+    int add_block() { return this->blocks++; }
+    // Grows the block count as needed.
+    void add_edge(int src, int dest);
+    void reserve_edges(size_t count);
+    cfg_graph build(int entry) const;
+};
+
+#endif
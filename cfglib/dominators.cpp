@@ -0,0 +1,273 @@
+#include <algorithm>
+#include <utility>
+
+#include "dominators.h"
+
+// Reachable blocks in DFS preorder, with the DFS tree parent of each
+// (as a preorder number).
+static void depth_first(const cfg_graph &graph, std::vector<int> &order, std::vector<int> &parent,
+                        std::vector<int> &number) {
+    int n = graph.num_blocks();
+    number.assign(n, -1);
+    order.clear();
+    parent.clear();
+    std::vector<std::pair<int, const int *>> stack;
+    number[graph.get_entry()] = 0;
+    order.push_back(graph.get_entry());
+    parent.push_back(-1);
+    stack.push_back({graph.get_entry(), graph.succs_begin(graph.get_entry())});
+    while (!stack.empty()) {
+        std::pair<int, const int *> &top = stack.back();
+        if (top.second == graph.succs_end(top.first)) {
+            stack.pop_back();
+            continue;
+        }
+        int succ = *top.second++;
+        if (number[succ] < 0) {
+            number[succ] = order.size();
+            parent.push_back(number[top.first]);
+            order.push_back(succ);
+            stack.push_back({succ, graph.succs_begin(succ)});
+        }
+    }
+}
+
+dominator_tree::dominator_tree(const cfg_graph &graph) {
+    int n = graph.num_blocks();
+    std::vector<int> parent, number;
+    depth_first(graph, this->dfs_order, parent, number);
+    int count = this->dfs_order.size();
+
+    // Everything below works on DFS preorder numbers.
+    std::vector<int> semi(count), label(count), ancestor(count, -1), dom(count, -1);
+    std::vector<int> bucket_head(count, -1), bucket_next(count, -1);
+    std::vector<int> path;
+    for (int v = 0; v < count; ++v) {
+        semi[v] = v;
+        label[v] = v;
+    }
+    // Returns the vertex with minimal semi on the forest path to v,
+    // compressing the path on the way.
+    auto eval = [&](int v) {
+        if (ancestor[v] < 0) {
+            return v;
+        }
+        for (int x = v; ancestor[ancestor[x]] >= 0; x = ancestor[x]) {
+            path.push_back(x);
+        }
+        while (!path.empty()) {
+            int x = path.back();
+            path.pop_back();
+            int a = ancestor[x];
+            if (semi[label[a]] < semi[label[x]]) {
+                label[x] = label[a];
+            }
+            ancestor[x] = ancestor[a];
+        }
+        return label[v];
+    };
+
+    for (int w = count - 1; w > 0; --w) {
+        int block = this->dfs_order[w];
+        for (const int *p = graph.preds_begin(block); p != graph.preds_end(block); ++p) {
+            int v = number[*p];
+            if (v >= 0) {
+                int u = eval(v);
+                semi[w] = std::min(semi[w], semi[u]);
+            }
+        }
+        bucket_next[w] = bucket_head[semi[w]];
+        bucket_head[semi[w]] = w;
+        int pw = parent[w];
+        ancestor[w] = pw;
+        for (int v = bucket_head[pw]; v >= 0; v = bucket_next[v]) {
+            int u = eval(v);
+            dom[v] = semi[u] < semi[v] ? u : pw;
+        }
+        bucket_head[pw] = -1;
+    }
+    for (int w = 1; w < count; ++w) {
+        if (dom[w] != semi[w]) {
+            dom[w] = dom[dom[w]];
+        }
+    }
+
+    this->idom.assign(n, -1);
+    for (int w = 1; w < count; ++w) {
+        this->idom[this->dfs_order[w]] = this->dfs_order[dom[w]];
+    }
+    this->build_tree(graph.get_entry());
+}
+
+void dominator_tree::build_tree(int entry) {
+    int n = this->idom.size();
+    this->child_offsets.assign(n + 1, 0);
+    for (int b = 0; b < n; ++b) {
+        if (this->idom[b] >= 0) {
+            this->child_offsets[this->idom[b] + 1]++;
+        }
+    }
+    for (int b = 0; b < n; ++b) {
+        this->child_offsets[b + 1] += this->child_offsets[b];
+    }
+    this->child_list.resize(this->child_offsets[n]);
+    std::vector<int> next(this->child_offsets.begin(), this->child_offsets.end() - 1);
+    // DFS order keeps the children of each block in discovery order.
+    for (int b : this->dfs_order) {
+        if (this->idom[b] >= 0) {
+            this->child_list[next[this->idom[b]]++] = b;
+        }
+    }
+
+    this->preorder.assign(n, -1);
+    this->postorder.assign(n, -1);
+    int pre = 0, post = 0;
+    std::vector<std::pair<int, const int *>> stack;
+    this->preorder[entry] = pre++;
+    stack.push_back({entry, this->children_begin(entry)});
+    while (!stack.empty()) {
+        std::pair<int, const int *> &top = stack.back();
+        if (top.second == this->children_end(top.first)) {
+            this->postorder[top.first] = post++;
+            stack.pop_back();
+            continue;
+        }
+        int child = *top.second++;
+        this->preorder[child] = pre++;
+        stack.push_back({child, this->children_begin(child)});
+    }
+}
+
+std::vector<int> dominator_tree::tree_preorder() const {
+    std::vector<int> order(this->dfs_order.size());
+    for (int b : this->dfs_order) {
+        order[this->preorder[b]] = b;
+    }
+    return order;
+}
+
+std::vector<int> iterative_idoms(const cfg_graph &graph) {
+    // Reverse postorder of the DFS.
+    std::vector<int> rpo_number(graph.num_blocks(), -1);
+    std::vector<int> rpo;
+    {
+        std::vector<std::pair<int, const int *>> stack;
+        std::vector<char> seen(graph.num_blocks(), 0);
+        seen[graph.get_entry()] = 1;
+        stack.push_back({graph.get_entry(), graph.succs_begin(graph.get_entry())});
+        while (!stack.empty()) {
+            std::pair<int, const int *> &top = stack.back();
+            if (top.second == graph.succs_end(top.first)) {
+                rpo.push_back(top.first);
+                stack.pop_back();
+                continue;
+            }
+            int succ = *top.second++;
+            if (!seen[succ]) {
+                seen[succ] = 1;
+                stack.push_back({succ, graph.succs_begin(succ)});
+            }
+        }
+        std::reverse(rpo.begin(), rpo.end());
+        for (size_t i = 0; i < rpo.size(); ++i) {
+            rpo_number[rpo[i]] = i;
+        }
+    }
+
+    std::vector<int> idom(graph.num_blocks(), -1);
+    int entry = graph.get_entry();
+    idom[entry] = entry;
+    auto intersect = [&](int a, int b) {
+        while (a != b) {
+            while (rpo_number[a] > rpo_number[b]) {
+                a = idom[a];
+            }
+            while (rpo_number[b] > rpo_number[a]) {
+                b = idom[b];
+            }
+        }
+        return a;
+    };
+    for (bool changed = true; changed;) {
+        changed = false;
+        for (size_t i = 1; i < rpo.size(); ++i) {
+            int b = rpo[i];
+            int new_idom = -1;
+            for (const int *p = graph.preds_begin(b); p != graph.preds_end(b); ++p) {
+                if (idom[*p] >= 0) {
+                    new_idom = new_idom < 0 ? *p : intersect(*p, new_idom);
+                }
+            }
+            if (idom[b] != new_idom) {
+                idom[b] = new_idom;
+                changed = true;
+            }
+        }
+    }
+    idom[entry] = -1;
+    return idom;
+}
+
+dominance_frontiers::dominance_frontiers(const cfg_graph &graph, const dominator_tree &dom) {
+    int n = graph.num_blocks();
+    std::vector<int> from, to;
+    // last[r] == b once b is in DF(r), so each pair is added once and the
+    // walk can stop at a runner that already has b.
+    std::vector<int> last(n, -1);
+    for (int b = 0; b < n; ++b) {
+        // The entry is a join point too: control also enters from outside.
+        if ((graph.num_preds(b) < 2 && b != graph.get_entry()) || !dom.reachable(b)) {
+            continue;
+        }
+        for (const int *p = graph.preds_begin(b); p != graph.preds_end(b); ++p) {
+            if (!dom.reachable(*p)) {
+                continue;
+            }
+            for (int runner = *p; runner != dom.get_idom(b) && last[runner] != b; runner = dom.get_idom(runner)) {
+                last[runner] = b;
+                from.push_back(runner);
+                to.push_back(b);
+            }
+        }
+    }
+    this->offsets.assign(n + 1, 0);
+    for (int r : from) {
+        this->offsets[r + 1]++;
+    }
+    for (int b = 0; b < n; ++b) {
+        this->offsets[b + 1] += this->offsets[b];
+    }
+    this->list.resize(from.size());
+    std::vector<int> next(this->offsets.begin(), this->offsets.end() - 1);
+    for (size_t i = 0; i < from.size(); ++i) {
+        this->list[next[from[i]]++] = to[i];
+    }
+}
+
+std::vector<int> dominance_frontiers::iterated(const std::vector<int> &blocks) const {
+    int n = this->offsets.size() - 1;
+    std::vector<char> in_result(n, 0), queued(n, 0);
+    std::vector<int> work, result;
+    for (int b : blocks) {
+        if (!queued[b]) {
+            queued[b] = 1;
+            work.push_back(b);
+        }
+    }
+    while (!work.empty()) {
+        int b = work.back();
+        work.pop_back();
+        for (const int *f = this->begin(b); f != this->end(b); ++f) {
+            if (!in_result[*f]) {
+                in_result[*f] = 1;
+                result.push_back(*f);
+                if (!queued[*f]) {
+                    queued[*f] = 1;
+                    work.push_back(*f);
+                }
+            }
+        }
+    }
+    std::sort(result.begin(), result.end());
+    return result;
+}
@@ -0,0 +1,67 @@
+#ifndef DOMINATORS_H
+#define DOMINATORS_H
+
+#include <vector>
+
+#include "cfg_graph.h"
+
+// Dominator tree of a cfg_graph, computed with the Lengauer-Tarjan
+// algorithm (simple eval/link with path compression, O(E log V)). Every
+// traversal is iterative, so graphs with millions of blocks do not
+// overflow the stack. Unreachable blocks have no immediate dominator and
+// neither dominate nor are dominated by anything.
+class dominator_tree {
+private:
+    std::vector<int> idom;
+    std::vector<int> preorder;   // dominator tree preorder number, -1 if unreachable
+    std::vector<int> postorder;  // dominator tree postorder number
+    std::vector<int> child_offsets;
+    std::vector<int> child_list;
+    std::vector<int> dfs_order;  // reachable blocks in CFG DFS preorder
+
+    void build_tree(int entry);
+
+public:
+    dominator_tree(const cfg_graph &graph);
+
+    // -1 for the entry and unreachable blocks.
+    int get_idom(int b) const { return this->idom[b]; }
+    bool reachable(int b) const { return this->preorder[b] >= 0; }
+    // Reflexive: every reachable block dominates itself.
+    bool dominates(int a, int b) const {
+        return this->preorder[a] >= 0 && this->preorder[b] >= 0 && this->preorder[a] <= this->preorder[b]
+            && this->postorder[b] <= this->postorder[a];
+    }
+    const int *children_begin(int b) const { return this->child_list.data() + this->child_offsets[b]; }
+    const int *children_end(int b) const { return this->child_list.data() + this->child_offsets[b + 1]; }
+    // Reachable blocks in CFG depth-first preorder.
+    const std::vector<int> &get_dfs_order() const { return this->dfs_order; }
+    // Reachable blocks ordered so that every block follows its dominators.
+    std::vector<int> tree_preorder() const;
+};
+
+// Immediate dominators by the Cooper-Harvey-Kennedy iterative algorithm.
+// Quadratic in the worst case but simple; used to cross-check
+// dominator_tree on test graphs.
+std::vector<int> iterative_idoms(const cfg_graph &graph);
+
+// Dominance frontiers, computed with the Cooper-Harvey-Kennedy runner
+// walk over join points, stored in CSR form.
+class dominance_frontiers {
+private:
+    std::vector<int> offsets;
+    std::vector<int> list;
+
+public:
+    dominance_frontiers(const cfg_graph &graph, const dominator_tree &dom);
+
+    const int *begin(int b) const { return this->list.data() + this->offsets[b]; }
+    const int *end(int b) const { return this->list.data() + this->offsets[b + 1]; }
+    int size(int b) const { return this->offsets[b + 1] - this->offsets[b]; }
+
+    // DF+(blocks): the blocks that need a phi for a variable defined in
+    // `blocks`. Sorted by id.
+    std::vector<int> iterated(const std::vector<int> &blocks) const;
+};
+
+#endif
@@ -0,0 +1,24 @@
+#ifndef GCC_CFG_H
+#define GCC_CFG_H
+
+#include "cfg_graph.h"
+
+// Adapter for GCC plugins: include after the GCC headers that declare
+// basic_block (gcc-plugin.h, basic-block.h), with <vector> included before
+// them as GCC's system.h requires. Block ids are bb->index, so ENTRY_BLOCK
+// is the entry and the indices of deleted blocks are unreachable.
+inline cfg_graph cfg_graph_from_gcc(function *func) {
+    cfg_graph_builder builder(last_basic_block_for_fn(func));
+    builder.reserve_edges(n_edges_for_fn(func));
+    basic_block bb;
+    FOR_ALL_BB_FN(bb, func) {
+        edge e;
+        edge_iterator ei;
+        FOR_EACH_EDGE(e, ei, bb->succs) {
+            builder.add_edge(bb->index, e->dest->index);
+        }
+    }
+    return builder.build(ENTRY_BLOCK);
+}
+
+#endif
@@ -0,0 +1,103 @@
+#include "lab3_cfg.h"
+
+namespace {
+
+class lab3_cfg_builder {
+private:
+    cfg_graph_builder builder;
+    std::vector<std::string> &labels;
+
+    int add_block(const char *label) {
+        this->labels.push_back(label);
+        return this->builder.add_block();
+    }
+
+public:
+    // Block 0 is the entry block, alloc.
+    lab3_cfg_builder(std::vector<std::string> &labels) : builder(1), labels(labels) {
+        this->labels.push_back("alloc");
+    }
+
+    // Mirrors IRGenerator::generate: returns the block that control falls
+    // out of, or -1 after a return.
+    int generate(const std::shared_ptr<Node> &tree, int parent);
+    int finish(int last);
+    cfg_graph build() const { return this->builder.build(0); }
+};
+
+int lab3_cfg_builder::generate(const std::shared_ptr<Node> &tree, int parent) {
+    switch (tree->rule) {
+        case S: {
+            int prev = parent;
+            for (const std::shared_ptr<Node> &child : tree->children) {
+                if (prev < 0) {
+                    return -1;
+                }
+                prev = this->generate(child, prev);
+            }
+            return prev;
+        }
+        case BB: {
+            int bb = this->add_block("BB");
+            this->builder.add_edge(parent, bb);
+            for (const std::shared_ptr<Node> &child : tree->children) {
+                if (child->rule == RETURN_RULE) {
+                    return -1;
+                }
+            }
+            return bb;
+        }
+        case IF_RULE: {
+            int header = this->add_block("if_header");
+            this->builder.add_edge(parent, header);
+            int branch_true = this->add_block("true");
+            int branch_false = this->add_block("false");
+            int merge = this->add_block("if_merge");
+            this->builder.add_edge(header, branch_true);
+            this->builder.add_edge(header, branch_false);
+            int bbt = this->generate(tree->children[1], branch_true);
+            if (bbt >= 0) {
+                this->builder.add_edge(bbt, merge);
+            }
+            int bbf = this->generate(tree->children[2], branch_false);
+            if (bbf >= 0) {
+                this->builder.add_edge(bbf, merge);
+            }
+            return merge;
+        }
+        case WHILE_RULE: {
+            int header = this->add_block("while_header");
+            this->builder.add_edge(parent, header);
+            int loop = this->add_block("loop");
+            int content = this->generate(tree->children[1], loop);
+            if (content >= 0) {
+                this->builder.add_edge(content, header);
+            }
+            int out = this->add_block("while_out");
+            this->builder.add_edge(header, loop);
+            this->builder.add_edge(header, out);
+            return out;
+        }
+        default:
+            return -1;
+    }
+}
+
+int lab3_cfg_builder::finish(int last) {
+    if (last < 0) {
+        return -1;
+    }
+    int ret = this->add_block("return");
+    this->builder.add_edge(last, ret);
+    return ret;
+}
+
+}
+
+lab3_cfg build_lab3_cfg(const std::shared_ptr<Node> &program) {
+    lab3_cfg cfg;
+    lab3_cfg_builder builder(cfg.labels);
+    builder.finish(builder.generate(program, 0));
+    cfg.graph = builder.build();
+    return cfg;
+}
@@ -0,0 +1,22 @@
+#ifndef LAB3_CFG_H
+#define LAB3_CFG_H
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "cfg_graph.h"
+#include "parser.h"
+
+// The CFG that lab3's IRGenerator emits for a program, built from the AST
+// without LLVM. Blocks are created in the same order and carry the same
+// labels (alloc, BB, if_header, true, false, if_merge, while_header, loop,
+// while_out, return); block 0 is the entry.
+struct lab3_cfg {
+    cfg_graph graph;
+    std::vector<std::string> labels;
+};
+
+lab3_cfg build_lab3_cfg(const std::shared_ptr<Node> &program);
+
+#endif
@@ -0,0 +1,51 @@
+#include <iostream>
+#include <vector>
+
+#include "dominators.h"
+#include "lab3_cfg.h"
+#include "loops.h"
+#include "parser.h"
+
+// Reads a lab3 program from stdin and prints, for each block of the CFG
+// that lab3's compiler would emit, its immediate dominator, loop depth and
+// dominance frontier.
+int main() {
+    std::vector<Token> tokens;
+    while (true) {
+        Token token = yylex();
+        tokens.push_back(token);
+        if (token.type == EOF_TOKEN) {
+            break;
+        }
+    }
+    Parser parser(tokens);
+    std::shared_ptr<Node> tree;
+    try {
+        tree = parser.parse();
+    } catch (SyntaxError err) {
+        std::cout << err.what() << std::endl;
+        return 1;
+    }
+
+    lab3_cfg cfg = build_lab3_cfg(tree);
+    dominator_tree dom(cfg.graph);
+    dominance_frontiers df(cfg.graph, dom);
+    loop_forest loops(cfg.graph, dom);
+    for (int b = 0; b < cfg.graph.num_blocks(); ++b) {
+        std::cout << b << " " << cfg.labels[b];
+        if (!dom.reachable(b)) {
+            std::cout << " unreachable\n";
+            continue;
+        }
+        std::cout << " idom=" << dom.get_idom(b) << " depth=" << loops.loop_depth(b);
+        if (loops.is_header(b)) {
+            std::cout << " header";
+        }
+        std::cout << " df={";
+        for (const int *f = df.begin(b); f != df.end(b); ++f) {
+            std::cout << (f == df.begin(b) ? "" : ",") << *f;
+        }
+        std::cout << "}\n";
+    }
+    return 0;
+}
@@ -0,0 +1,73 @@
+#include "loops.h"
+
+loop_forest::loop_forest(const cfg_graph &graph, const dominator_tree &dom) {
+    int n = graph.num_blocks();
+    this->block_loops.assign(n, -1);
+
+    // Inner headers are deeper in the dominator tree, so walking its
+    // preorder backwards finds inner loops first.
+    std::vector<int> order = dom.tree_preorder();
+    // top[l] leads to the outermost loop found so far that contains l.
+    std::vector<int> top;
+    auto find = [&](int l) {
+        int root = l;
+        while (top[root] != root) {
+            root = top[root];
+        }
+        while (top[l] != root) {
+            int next = top[l];
+            top[l] = root;
+            l = next;
+        }
+        return root;
+    };
+
+    std::vector<int> work;
+    for (auto it = order.rbegin(); it != order.rend(); ++it) {
+        int header = *it;
+        for (const int *p = graph.preds_begin(header); p != graph.preds_end(header); ++p) {
+            if (dom.dominates(header, *p)) {
+                work.push_back(*p);
+            }
+        }
+        if (work.empty()) {
+            continue;
+        }
+        int loop = this->headers.size();
+        this->headers.push_back(header);
+        this->parents.push_back(-1);
+        top.push_back(loop);
+        this->block_loops[header] = loop;
+        while (!work.empty()) {
+            int b = work.back();
+            work.pop_back();
+            if (!dom.reachable(b)) {
+                continue;
+            }
+            int from = b;
+            if (this->block_loops[b] < 0) {
+                this->block_loops[b] = loop;
+            } else {
+                int inner = find(this->block_loops[b]);
+                if (inner == loop) {
+                    continue;
+                }
+                // An inner loop: continue from its header.
+                this->parents[inner] = loop;
+                top[inner] = loop;
+                from = this->headers[inner];
+            }
+            for (const int *p = graph.preds_begin(from); p != graph.preds_end(from); ++p) {
+                work.push_back(*p);
+            }
+        }
+    }
+
+    // Parents have larger ids.
+    this->depths.assign(this->headers.size(), 1);
+    for (int l = (int) this->headers.size() - 1; l >= 0; --l) {
+        if (this->parents[l] >= 0) {
+            this->depths[l] = this->depths[this->parents[l]] + 1;
+        }
+    }
+}
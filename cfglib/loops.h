@@ -0,0 +1,39 @@
+#ifndef LOOPS_H
+#define LOOPS_H
+
+#include <vector>
+
+#include "cfg_graph.h"
+#include "dominators.h"
+
+// Loop nesting forest of the natural loops of a cfg_graph. A loop is
+// identified by its header, a block that dominates the source of one of
+// its incoming edges; all back edges to one header form one loop.
+// Cycles entered at several blocks (irreducible regions) have no header
+// and are not loops here. Loop ids are ordered inner before outer.
+class loop_forest {
+private:
+    std::vector<int> headers;
+    std::vector<int> parents;
+    std::vector<int> depths;
+    std::vector<int> block_loops;  // innermost loop of each block, -1 if none
+
+public:
+    loop_forest(const cfg_graph &graph, const dominator_tree &dom);
+
+    int num_loops() const { return this->headers.size(); }
+    int get_header(int loop) const { return this->headers[loop]; }
+    // -1 for outermost loops.
+    int get_parent(int loop) const { return this->parents[loop]; }
+    // Outermost loops have depth 1.
+    int get_depth(int loop) const { return this->depths[loop]; }
+    int loop_of(int block) const { return this->block_loops[block]; }
+    int loop_depth(int block) const {
+        return this->block_loops[block] < 0 ? 0 : this->depths[this->block_loops[block]];
+    }
+    bool is_header(int block) const {
+        return this->block_loops[block] >= 0 && this->headers[this->block_loops[block]] == block;
+    }
+};
+
+#endif
@@ -0,0 +1,219 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+#include "stats_format.h"
+
+// Measures what gimple_print.so adds to compile time and peak memory.
+// Every source is compiled RUNS times with and without the plugin; the
+// best CPU time (user + sys of gcc and its children, from wait4) and the
+// peak RSS are kept. The block count comes from one extra compilation in
+// the plugin's stats mode. Results are normalized per 1000 blocks and
+// compared with the baseline file, which is written if it does not exist.
+// Usage: compile_bench [-r RUNS] [-O LEVEL] [-b BASELINE] [-w] [-t PERCENT]
+//                      PLUGIN SOURCE...
+
+struct measurement {
+    double cpu_ms;
+    double wall_ms;
+    long max_rss_kb;
+};
+
+struct baseline_entry {
+    double ms_per_kblock;
+    double kb_per_kblock;
+};
+
+static double elapsed_ms(const timespec &start, const timespec &end) {
+    return (end.tv_sec - start.tv_sec) * 1e3 + (end.tv_nsec - start.tv_nsec) / 1e6;
+}
+
+// Runs args with stdout and stderr discarded; false if it did not exit 0.
+static bool run(const std::vector<std::string> &args, measurement &m) {
+    std::vector<char *> argv;
+    for (const std::string &arg : args) {
+        argv.push_back((char *) arg.c_str());
+    }
+    argv.push_back(nullptr);
+
+    timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    pid_t pid = fork();
+    if (pid < 0) {
+        return false;
+    }
+    if (pid == 0) {
+        int null = open("/dev/null", O_WRONLY);
+        dup2(null, STDOUT_FILENO);
+        dup2(null, STDERR_FILENO);
+        execvp(argv[0], argv.data());
+        _exit(127);
+    }
+    int status;
+    struct rusage usage;
+    while (wait4(pid, &status, 0, &usage) < 0) {
+        if (errno != EINTR) {
+            return false;
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    m.wall_ms = elapsed_ms(start, end);
+    m.cpu_ms = (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1e3
+             + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e3;
+    m.max_rss_kb = usage.ru_maxrss;
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+static bool best_of(const std::vector<std::string> &args, int runs, measurement &best) {
+    for (int i = 0; i < runs; ++i) {
+        measurement m;
+        if (!run(args, m)) {
+            return false;
+        }
+        if (i == 0 || m.cpu_ms < best.cpu_ms) {
+            best.cpu_ms = m.cpu_ms;
+            best.wall_ms = m.wall_ms;
+        }
+        best.max_rss_kb = i == 0 ? m.max_rss_kb : std::max(best.max_rss_kb, m.max_rss_kb);
+    }
+    return true;
+}
+
+static long long count_blocks(const std::vector<std::string> &compile, const std::string &plugin) {
+    char path[] = "/tmp/compile_bench_stats_XXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0) {
+        return -1;
+    }
+    close(fd);
+    unlink(path);
+    std::vector<std::string> args = compile;
+    args.push_back("-fplugin=" + plugin);
+    args.push_back(std::string("-fplugin-arg-gimple_print-stats=") + path);
+    measurement m;
+    long long blocks = -1;
+    if (run(args, m)) {
+        stats_header h;
+        std::ifstream in(path, std::ios::binary);
+        if (in.read((char *) &h, sizeof(h)) && !memcmp(h.magic, STATS_FORMAT_MAGIC, sizeof(h.magic))
+            && h.version == STATS_FORMAT_VERSION) {
+            blocks = h.blocks;
+        }
+    }
+    unlink(path);
+    return blocks;
+}
+
+static std::map<std::string, baseline_entry> read_baseline(const std::string &path) {
+    std::map<std::string, baseline_entry> baseline;
+    std::ifstream in(path);
+    std::string line;
+    while (std::getline(in, line)) {
+        std::istringstream fields(line);
+        std::string source;
+        baseline_entry e;
+        if (!line.empty() && line[0] != '#' && fields >> source >> e.ms_per_kblock >> e.kb_per_kblock) {
+            baseline[source] = e;
+        }
+    }
+    return baseline;
+}
+
+int main(int argc, char **argv) {
+    int runs = 3;
+    double threshold = 10;
+    std::string level = "-O0";
+    std::string baseline_path;
+    bool write_baseline = false;
+    std::vector<std::string> positional;
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "-r") && i + 1 < argc) {
+            runs = std::max(1, atoi(argv[++i]));
+        } else if (!strcmp(argv[i], "-O") && i + 1 < argc) {
+            level = std::string("-O") + argv[++i];
+        } else if (!strcmp(argv[i], "-b") && i + 1 < argc) {
+            baseline_path = argv[++i];
+        } else if (!strcmp(argv[i], "-w")) {
+            write_baseline = true;
+        } else if (!strcmp(argv[i], "-t") && i + 1 < argc) {
+            threshold = atof(argv[++i]);
+        } else {
+            positional.push_back(argv[i]);
+        }
+    }
+    if (positional.size() < 2) {
+        std::cerr << "usage: " << argv[0] << " [-r RUNS] [-O LEVEL] [-b BASELINE] [-w] [-t PERCENT] PLUGIN SOURCE..."
+                  << std::endl;
+        return 2;
+    }
+    std::string plugin = positional[0];
+    std::map<std::string, baseline_entry> baseline;
+    struct stat st;
+    if (!baseline_path.empty() && stat(baseline_path.c_str(), &st) == 0 && !write_baseline) {
+        baseline = read_baseline(baseline_path);
+    } else if (!baseline_path.empty()) {
+        write_baseline = true;
+    }
+
+    std::string recorded = "# source ms_per_1000_blocks kb_per_1000_blocks\n";
+    int regressions = 0;
+    printf("%-24s %8s %10s %10s %12s %9s %9s %12s\n", "source", "blocks", "base ms", "plugin ms", "+ms/1k bb",
+           "base MB", "plugin MB", "+KB/1k bb");
+    for (size_t i = 1; i < positional.size(); ++i) {
+        const std::string &source = positional[i];
+        std::vector<std::string> compile = {"gcc", level, "-c", "-o", "/dev/null", source};
+        std::vector<std::string> with_plugin = compile;
+        with_plugin.push_back("-fplugin=" + plugin);
+
+        measurement base, loaded;
+        long long blocks = count_blocks(compile, plugin);
+        if (blocks <= 0 || !best_of(compile, runs, base) || !best_of(with_plugin, runs, loaded)) {
+            std::cerr << source << ": compilation failed" << std::endl;
+            return 1;
+        }
+        double ms = (loaded.cpu_ms - base.cpu_ms) * 1000 / blocks;
+        double kb = (double) (loaded.max_rss_kb - base.max_rss_kb) * 1000 / blocks;
+        printf("%-24s %8lld %10.1f %10.1f %12.3f %9.1f %9.1f %12.1f", source.c_str(), blocks, base.cpu_ms,
+               loaded.cpu_ms, ms, base.max_rss_kb / 1024.0, loaded.max_rss_kb / 1024.0, kb);
+
+        auto it = baseline.find(source);
+        if (it != baseline.end()) {
+            // Small absolute slack so near-zero baselines do not flag noise.
+            bool slower = ms > it->second.ms_per_kblock * (1 + threshold / 100) + 0.05;
+            bool larger = kb > it->second.kb_per_kblock * (1 + threshold / 100) + 16;
+            if (slower || larger) {
+                printf("  REGRESSION (baseline %.3f ms, %.1f KB)", it->second.ms_per_kblock, it->second.kb_per_kblock);
+                regressions++;
+            }
+        }
+        printf("\n");
+        char line[64];
+        snprintf(line, sizeof(line), " %.3f %.1f\n", ms, kb);
+        recorded += source + line;
+    }
+
+    if (write_baseline) {
+        std::ofstream out(baseline_path);
+        out << recorded;
+        if (!out) {
+            std::cerr << "cannot write " << baseline_path << std::endl;
+            return 1;
+        }
+        printf("baseline written to %s\n", baseline_path.c_str());
+    }
+    return regressions ? 1 : 0;
+}
@@ -0,0 +1,59 @@
+#!/bin/bash
+# Compares the run time of plain, -fprofile-arcs and plugin-instrumented
+# builds of src/test.c and bench/synthetic.c.
+# Usage: bench/counters.sh [RUNS]  (from lab1/, after make build)
+set -e
+
+RUNS=${1:-5}
+OUT=./out/bench
+PLUGIN=./out/gimple_print.so
+# -fprofile-arcs results go under GCOV_PREFIX, mirroring the object path.
+GCOV_DIR=$OUT/gcov
+mkdir -p $OUT
+
+build() {
+    local name=$1 src=$2
+    gcc -O2 -o $OUT/$name.plain $src
+    gcc -O2 -fprofile-arcs -o $OUT/$name.arcs $src
+    gcc -O2 -fplugin=$PLUGIN -fplugin-arg-gimple_print-instrument -c -o $OUT/$name.o $src
+    gcc -O2 -c -o $OUT/runtime.o ./src/bb_counters_runtime.c
+    gcc -o $OUT/$name.counters $OUT/$name.o $OUT/runtime.o
+}
+
+# Prints the best wall time of RUNS runs in nanoseconds.
+# Usage: best_time INPUT COMMAND...
+best_time() {
+    local input=$1 best=
+    shift
+    for ((i = 0; i < RUNS; ++i)); do
+        local start=$(date +%s%N)
+        "$@" < $input > /dev/null
+        local t=$(($(date +%s%N) - start))
+        if [ -z "$best" ] || [ $t -lt $best ]; then
+            best=$t
+        fi
+    done
+    echo $best
+}
+
+# Usage: report NAME INPUT ARGS...
+report() {
+    local name=$1 input=$2
+    shift 2
+    rm -rf $GCOV_DIR
+    rm -f $OUT/bb_counters.txt
+    local plain=$(best_time $input $OUT/$name.plain "$@")
+    local arcs=$(GCOV_PREFIX=$GCOV_DIR best_time $input $OUT/$name.arcs "$@")
+    local counters=$(GIMPLE_PRINT_COUNTERS=$OUT/bb_counters.txt best_time $input $OUT/$name.counters "$@")
+    awk -v name=$name -v plain=$plain -v arcs=$arcs -v counters=$counters 'BEGIN {
+        printf "%-10s plain %8.3fs  profile-arcs %8.3fs (%+6.1f%%)  counters %8.3fs (%+6.1f%%)\n", name,
+            plain / 1e9, arcs / 1e9, 100 * (arcs - plain) / plain, counters / 1e9, 100 * (counters - plain) / plain
+    }'
+}
+
+build test ./src/test.c
+build synthetic ./bench/synthetic.c
+
+echo 20000000 > $OUT/test.in
+report test $OUT/test.in
+report synthetic /dev/null 200
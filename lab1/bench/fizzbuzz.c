@@ -0,0 +1,20 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+// The loop of src/test.c without printf, so the modulo dominates.
+int main(int argc, char **argv) {
+    int n = argc > 1 ? atoi(argv[1]) : 100000000;
+    long long fizzbuzz = 0, fizz = 0, buzz = 0, sum = 0;
+    for (int i = 0; i < n; ++i) {
+        if (i % 15 == 0) {
+            fizzbuzz += i;
+        } else if (i % 3 == 0) {
+            fizz += i;
+        } else if (i % 5 == 0) {
+            buzz += i;
+        }
+        sum += i % 7;
+    }
+    printf("%lld %lld %lld %lld\n", fizzbuzz, fizz, buzz, sum);
+    return 0;
+}
@@ -0,0 +1,104 @@
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+// Writes a synthetic C translation unit to stdout for compile time
+// benchmarks. Every function has DEPTH nested loops whose innermost body
+// is a chain of if/else diamonds; each diamond assigns PHIS variables on
+// both sides, so it adds about three blocks and PHIS PHIs at its join.
+// Usage: gen_tu [-f FUNCTIONS] [-b BLOCKS] [-d DEPTH] [-p PHIS] [-s SEED]
+
+static unsigned int state;
+
+static unsigned int next_random() {
+    state = state * 1103515245 + 12345;
+    return state >> 16;
+}
+
+static std::string var(int phis) {
+    return "v" + std::to_string(next_random() % phis);
+}
+
+static void indent(int level) {
+    std::cout << std::string(4 * level, ' ');
+}
+
+static void write_function(int index, int blocks, int depth, int phis) {
+    std::cout << "long f" << index << "(long n, const long *a) {\n";
+    for (int i = 0; i < phis; ++i) {
+        std::cout << "    long v" << i << " = a[" << i << "];\n";
+    }
+    for (int d = 0; d < depth; ++d) {
+        indent(d + 1);
+        std::cout << "for (long i" << d << " = 0; i" << d << " < n; ++i" << d << ") {\n";
+    }
+    int level = depth + 1;
+    int diamonds = std::max(1, (blocks - 3 * depth - 2) / 3);
+    for (int k = 0; k < diamonds; ++k) {
+        std::string i = depth ? "i" + std::to_string(next_random() % depth) : "n";
+        indent(level);
+        std::cout << "if ((" << var(phis) << " ^ " << i << ") % " << 3 + next_random() % 13 << " < "
+                  << 1 + next_random() % 3 << ") {\n";
+        for (int p = 0; p < phis; ++p) {
+            indent(level + 1);
+            std::cout << "v" << p << " = " << var(phis) << " + " << next_random() % 100 << ";\n";
+        }
+        indent(level);
+        std::cout << "} else {\n";
+        for (int p = 0; p < phis; ++p) {
+            indent(level + 1);
+            std::cout << "v" << p << " = " << var(phis) << " * " << 1 + next_random() % 7 << " - " << i << ";\n";
+        }
+        indent(level);
+        std::cout << "}\n";
+    }
+    for (int d = depth; d > 0; --d) {
+        indent(d);
+        std::cout << "}\n";
+    }
+    std::cout << "    return 0";
+    for (int i = 0; i < phis; ++i) {
+        std::cout << " + v" << i;
+    }
+    std::cout << ";\n}\n\n";
+}
+
+static int usage(const char *name) {
+    std::cerr << "usage: " << name << " [-f FUNCTIONS] [-b BLOCKS] [-d DEPTH] [-p PHIS] [-s SEED]" << std::endl;
+    return 2;
+}
+
+int main(int argc, char **argv) {
+    int functions = 100, blocks = 100, depth = 1, phis = 4;
+    state = 1;
+    for (int i = 1; i < argc; i += 2) {
+        if (i + 1 == argc) {
+            return usage(argv[0]);
+        }
+        int value = atoi(argv[i + 1]);
+        if (!strcmp(argv[i], "-f")) {
+            functions = value;
+        } else if (!strcmp(argv[i], "-b")) {
+            blocks = value;
+        } else if (!strcmp(argv[i], "-d")) {
+            depth = value;
+        } else if (!strcmp(argv[i], "-p")) {
+            phis = value;
+        } else if (!strcmp(argv[i], "-s")) {
+            state = value;
+        } else {
+            return usage(argv[0]);
+        }
+    }
+    if (functions < 1 || blocks < 1 || depth < 0 || phis < 1) {
+        std::cerr << "counts must be positive" << std::endl;
+        return 2;
+    }
+    std::cout << "/* gen_tu -f " << functions << " -b " << blocks << " -d " << depth << " -p " << phis << " */\n\n";
+    for (int i = 0; i < functions; ++i) {
+        write_function(i, blocks, depth, phis);
+    }
+    return 0;
+}
@@ -0,0 +1,50 @@
+#!/bin/bash
+# Checks that mod-reduce builds of src/test.c and bench/fizzbuzz.c print
+# the same as plain builds, then compares their run time.
+# Usage: bench/mod_reduce.sh [RUNS]  (from lab1/, after make build)
+set -e
+
+RUNS=${1:-5}
+OUT=./out/bench
+PLUGIN=./out/gimple_print.so
+mkdir -p $OUT
+
+for opt in -O0 -O2; do
+    gcc $opt -o $OUT/test.plain ./src/test.c
+    gcc $opt -fplugin=$PLUGIN -fplugin-arg-gimple_print-mod-reduce -o $OUT/test.reduced ./src/test.c
+    for n in 0 1 2 3 5 14 15 16 1000; do
+        if ! cmp -s <(echo $n | $OUT/test.plain) <(echo $n | $OUT/test.reduced); then
+            echo "test.c $opt: output differs for n=$n" >&2
+            exit 1
+        fi
+    done
+done
+
+gcc -O2 -o $OUT/fizzbuzz.plain ./bench/fizzbuzz.c
+gcc -O2 -fplugin=$PLUGIN -fplugin-arg-gimple_print-mod-reduce -o $OUT/fizzbuzz.reduced ./bench/fizzbuzz.c
+for n in 0 1 15 100 12345; do
+    if [ "$($OUT/fizzbuzz.plain $n)" != "$($OUT/fizzbuzz.reduced $n)" ]; then
+        echo "fizzbuzz.c: output differs for n=$n" >&2
+        exit 1
+    fi
+done
+
+# Prints the best wall time of RUNS runs in nanoseconds.
+best_time() {
+    local best=
+    for ((i = 0; i < RUNS; ++i)); do
+        local start=$(date +%s%N)
+        "$@" > /dev/null
+        local t=$(($(date +%s%N) - start))
+        if [ -z "$best" ] || [ $t -lt $best ]; then
+            best=$t
+        fi
+    done
+    echo $best
+}
+
+plain=$(best_time $OUT/fizzbuzz.plain 200000000)
+reduced=$(best_time $OUT/fizzbuzz.reduced 200000000)
+awk -v plain=$plain -v reduced=$reduced 'BEGIN {
+    printf "fizzbuzz   plain %8.3fs  mod-reduce %8.3fs (%+6.1f%%)\n", plain / 1e9, reduced / 1e9, 100 * (reduced - plain) / plain
+}'
@@ -0,0 +1,115 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* A larger block-count benchmark for the instrumentation pass: several
+ * small kernels with loops, nested branches and calls. */
+
+#define N 512
+
+static unsigned int state = 12345;
+
+static unsigned int next_random(void) {
+    state = state * 1103515245 + 12345;
+    return state >> 16;
+}
+
+static int sieve(int n) {
+    static char composite[1 << 16];
+    int primes = 0;
+    memset(composite, 0, n);
+    for (int i = 2; i < n; ++i) {
+        if (!composite[i]) {
+            ++primes;
+            for (int j = 2 * i; j < n; j += i) {
+                composite[j] = 1;
+            }
+        }
+    }
+    return primes;
+}
+
+static int collatz(int n) {
+    int longest = 0;
+    for (int i = 1; i < n; ++i) {
+        long long x = i;
+        int steps = 0;
+        while (x != 1) {
+            x = x % 2 ? 3 * x + 1 : x / 2;
+            ++steps;
+        }
+        if (steps > longest) {
+            longest = steps;
+        }
+    }
+    return longest;
+}
+
+static void insertion_sort(int *a, int n) {
+    for (int i = 1; i < n; ++i) {
+        int x = a[i], j = i - 1;
+        while (j >= 0 && a[j] > x) {
+            a[j + 1] = a[j];
+            --j;
+        }
+        a[j + 1] = x;
+    }
+}
+
+static long long matrix(int n) {
+    static int a[64][64], b[64][64];
+    long long trace = 0;
+    for (int i = 0; i < n; ++i) {
+        for (int j = 0; j < n; ++j) {
+            a[i][j] = next_random() % 10;
+            b[i][j] = next_random() % 10;
+        }
+    }
+    for (int i = 0; i < n; ++i) {
+        for (int j = 0; j < n; ++j) {
+            long long s = 0;
+            for (int k = 0; k < n; ++k) {
+                s += a[i][k] * b[k][j];
+            }
+            if (i == j) {
+                trace += s;
+            }
+        }
+    }
+    return trace;
+}
+
+static int classify(int x) {
+    if (x % 7 == 0) {
+        return x % 11 == 0 ? 3 : 2;
+    } else if (x % 13 == 0) {
+        return 1;
+    }
+    switch (x & 7) {
+        case 0: return 4;
+        case 1: return 5;
+        case 3: return 6;
+        default: return 0;
+    }
+}
+
+int main(int argc, char **argv) {
+    int rounds = argc > 1 ? atoi(argv[1]) : 20;
+    long long checksum = 0;
+    int data[N];
+    for (int r = 0; r < rounds; ++r) {
+        checksum += sieve(60000);
+        checksum += collatz(20000);
+        for (int i = 0; i < N; ++i) {
+            data[i] = next_random();
+        }
+        insertion_sort(data, N);
+        checksum += data[N / 2] % 1000;
+        checksum += matrix(64);
+        for (int i = 0; i < 100000; ++i) {
+            checksum += classify(i + r);
+        }
+    }
+    printf("%lld\n", checksum);
+    return 0;
+}
@@ -0,0 +1,153 @@
+#include <algorithm>
+#include <cstdio>
+#include <fcntl.h>
+#include <string>
+#include <unistd.h>
+
+#include "async_writer.h"
+#include "cfg_binary_writer.h"
+
+async_writer::async_writer(cfg_binary_writer *binary) : binary(binary), annotated(false), stopping(false) {}
+
+void async_writer::set_annotated(bool annotated) {
+    this->annotated = annotated;
+}
+
+async_writer::~async_writer() {
+    this->finish();
+}
+
+void async_writer::submit(write_job &&job) {
+    std::unique_lock<std::mutex> lock(this->mutex);
+    if (!this->thread.joinable()) {
+        this->stopping = false;
+        this->thread = std::thread(&async_writer::run, this);
+    }
+    this->not_full.wait(lock, [this] { return this->jobs.size() < max_pending; });
+    this->jobs.push_back(std::move(job));
+    this->not_empty.notify_one();
+}
+
+std::vector<std::string> async_writer::finish() {
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->stopping = true;
+        this->not_empty.notify_one();
+    }
+    if (this->thread.joinable()) {
+        this->thread.join();
+    }
+    return std::move(this->failures);
+}
+
+void async_writer::run() {
+    while (true) {
+        write_job job;
+        {
+            std::unique_lock<std::mutex> lock(this->mutex);
+            this->not_empty.wait(lock, [this] { return this->stopping || !this->jobs.empty(); });
+            if (this->jobs.empty()) {
+                return;
+            }
+            job = std::move(this->jobs.front());
+            this->jobs.pop_front();
+            this->not_full.notify_one();
+        }
+        this->process(job);
+    }
+}
+
+static bool write_buffer(const std::string &path, const std::string &buffer) {
+    if (path.empty()) {
+        return fwrite(buffer.data(), 1, buffer.size(), stdout) == buffer.size() && fflush(stdout) == 0;
+    }
+    FILE *file = fopen(path.c_str(), "w");
+    if (!file) {
+        return false;
+    }
+    bool ok = fwrite(buffer.data(), 1, buffer.size(), file) == buffer.size();
+    return fclose(file) == 0 && ok;
+}
+
+static bool append_buffer(const std::string &path, const std::string &buffer) {
+    if (buffer.empty()) {
+        return true;
+    }
+    int fd = open(path.c_str(), O_WRONLY | O_APPEND | O_CREAT, 0666);
+    if (fd < 0) {
+        return false;
+    }
+    bool ok = write(fd, buffer.data(), buffer.size()) == (ssize_t) buffer.size();
+    return close(fd) == 0 && ok;
+}
+
+void async_writer::collect_hot_blocks(const write_job &job) {
+    for (const bb_info_collector &bb : job.bbs) {
+        if (bb.get_annotations().count > 0) {
+            this->hot_blocks.push_back({job.function, bb.get_id(), bb.get_annotations()});
+        }
+    }
+}
+
+bool async_writer::write_hot_report(const std::string &path) {
+    static const size_t report_size = 100;
+    size_t n = std::min(report_size, this->hot_blocks.size());
+    std::partial_sort(this->hot_blocks.begin(), this->hot_blocks.begin() + n, this->hot_blocks.end(),
+                      [](const hot_block &a, const hot_block &b) {
+                          if (a.annotations.count != b.annotations.count) {
+                              return a.annotations.count > b.annotations.count;
+                          }
+                          return a.annotations.cost > b.annotations.cost;
+                      });
+    std::string buffer = "# count cost depth function bb\n";
+    for (size_t i = 0; i < n; ++i) {
+        const hot_block &b = this->hot_blocks[i];
+        buffer.append(std::to_string(b.annotations.count) + " " + std::to_string(b.annotations.cost) + " "
+                      + std::to_string(b.annotations.loop_depth) + " " + b.function + " "
+                      + std::to_string(b.index) + "\n");
+    }
+    return write_buffer(path, buffer);
+}
+
+void async_writer::process(write_job &job) {
+    bool ok = true;
+    if (this->annotated && (job.kind == write_job::GRAPHVIZ || job.kind == write_job::BINARY_FUNCTION)) {
+        this->collect_hot_blocks(job);
+    }
+    switch (job.kind) {
+        case write_job::GRAPHVIZ: {
+            long long max_count = 0;
+            for (const bb_info_collector &bb : job.bbs) {
+                max_count = std::max(max_count, bb.get_annotations().count);
+            }
+            std::string buffer;
+            buffer.append("digraph G {\n");
+            buffer.append("node [shape=\"box\"]\n");
+            for (const bb_info_collector &bb : job.bbs) {
+                bb.render_graphviz(buffer, this->annotated, max_count);
+            }
+            buffer.append("}\n");
+            ok = write_buffer(job.path, buffer);
+            break;
+        }
+        case write_job::BINARY_FUNCTION:
+            this->binary->add_function(job.function.c_str(), job.bbs);
+            break;
+        case write_job::BINARY_FILE:
+            ok = this->binary->write(job.path.c_str());
+            break;
+        case write_job::HOT_REPORT:
+            ok = this->write_hot_report(job.path);
+            break;
+        case write_job::TEXT:
+            ok = write_buffer(job.path, job.text);
+            break;
+        case write_job::APPEND_TEXT:
+            ok = append_buffer(job.path, job.text);
+            break;
+    }
+    if (!ok) {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->failures.push_back(job.path.empty() ? "<stdout>" : job.path);
+    }
+}
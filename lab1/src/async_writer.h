@@ -0,0 +1,73 @@
+#ifndef ASYNC_WRITER_H
+#define ASYNC_WRITER_H
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bb_info_collector.h"
+
+class cfg_binary_writer;
+
+struct hot_block {
+    std::string function;
+    int index;
+    block_annotations annotations;
+};
+
+struct write_job {
+    enum job_kind {
+        GRAPHVIZ,         // render bbs, write to path or stdout if path is empty
+        BINARY_FUNCTION,  // append bbs to the binary writer
+        BINARY_FILE,      // write the binary file to path
+        HOT_REPORT,       // write the hottest blocks seen so far to path
+        TEXT,             // write text to path or stdout if path is empty
+        APPEND_TEXT,      // append text to path in one write, so compilers can share it
+    };
+
+    job_kind kind;
+    std::string path;
+    std::string function;
+    std::string text;
+    std::vector<bb_info_collector> bbs;
+};
+
+// Background thread that renders and writes plugin output, so the compiler
+// thread only moves the collected records into the queue. Errors are
+// collected and reported by the compiler thread after finish().
+class async_writer {
+private:
+    static const size_t max_pending = 256;
+
+    cfg_binary_writer *binary;
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable not_empty;
+    std::condition_variable not_full;
+    std::deque<write_job> jobs;
+    std::vector<std::string> failures;
+    std::vector<hot_block> hot_blocks;
+    bool annotated;
+    bool stopping;
+
+    void run();
+    void process(write_job &job);
+    void collect_hot_blocks(const write_job &job);
+    bool write_hot_report(const std::string &path);
+
+public:
+    async_writer(cfg_binary_writer *binary);
+    ~async_writer();
+
+    // Render block annotations and keep them for the hot block report.
+    void set_annotated(bool annotated);
+
+    void submit(write_job &&job);
+    // Drains the queue and joins the thread; returns the failed paths.
+    std::vector<std::string> finish();
+};
+
+#endif
@@ -0,0 +1,145 @@
+#include <cstring>
+#include <string>
+
+#include "gcc-plugin.h"
+#include "tree.h"
+#include "tree-pass.h"
+#include "context.h"
+#include "gimple.h"
+#include "gimple-iterator.h"
+#include "stringpool.h"
+#include "stor-layout.h"
+#include "cgraph.h"
+#include "varasm.h"
+#include "builtins.h"
+#include "memmodel.h"
+#include "tree-into-ssa.h"
+#include "ggc.h"
+#include "diagnostic-core.h"
+
+#include "bb_counter_pass.h"
+#include "function_filter.h"
+
+static struct pass_data bb_counter_pass_data = {
+    .type = GIMPLE_PASS,
+    .name = "bb_counter",
+    .properties_required = PROP_cfg | PROP_ssa,
+    .todo_flags_finish = TODO_update_ssa,
+};
+
+// The record type is built once per compilation and outlives every
+// function, so it is a GC root rather than a member of the pass; the fields
+// are reachable from it through TYPE_FIELDS.
+static tree counter_type;
+static tree count_field;
+static tree function_field;
+static tree index_field;
+
+static const struct ggc_root_tab bb_counter_roots[] = {
+    {&counter_type, 1, sizeof(counter_type), &gt_ggc_mx_tree_node, &gt_pch_nx_tree_node},
+    LAST_GGC_ROOT_TAB,
+};
+
+struct bb_counter_pass : gimple_opt_pass {
+    const function_filter *filter;
+
+    bb_counter_pass(gcc::context *ctx, const function_filter *filter)
+        : gimple_opt_pass(bb_counter_pass_data, ctx), filter(filter) {}
+    virtual bb_counter_pass *clone() override { return this; }
+    virtual bool gate(function *func) override;
+    virtual unsigned int execute(function *func) override;
+};
+
+bool bb_counter_pass::gate(function *func) {
+    return this->filter->matches(function_name(func));
+}
+
+// struct { unsigned long long count; const char *function; long long bb; },
+// kept in sync with bb_counters_runtime.c.
+static void build_counter_type() {
+    counter_type = make_node(RECORD_TYPE);
+    count_field = build_decl(BUILTINS_LOCATION, FIELD_DECL, get_identifier("count"),
+                                   long_long_unsigned_type_node);
+    function_field = build_decl(BUILTINS_LOCATION, FIELD_DECL, get_identifier("function"),
+                                      build_pointer_type(build_qualified_type(char_type_node, TYPE_QUAL_CONST)));
+    index_field = build_decl(BUILTINS_LOCATION, FIELD_DECL, get_identifier("bb"),
+                                   long_long_integer_type_node);
+    // finish_builtin_struct expects the fields in reverse order.
+    DECL_CHAIN(index_field) = function_field;
+    DECL_CHAIN(function_field) = count_field;
+    finish_builtin_struct(counter_type, "__gimple_print_counter", index_field, NULL_TREE);
+}
+
+// One array per function: passes run function by function, so the size of
+// a single per-unit array is not known until every function has been
+// instrumented. The arrays share BB_COUNTER_SECTION, which the linker lays
+// out back to back, so the runtime still sees one array per program.
+static tree build_counters(function *func, int count) {
+    const char *name = function_name(func);
+    tree array_type = build_array_type_nelts(counter_type, count);
+    std::string var_name = "__gimple_print_counters_" + std::to_string(func->funcdef_no);
+    tree var = build_decl(BUILTINS_LOCATION, VAR_DECL, get_identifier(var_name.c_str()), array_type);
+    TREE_STATIC(var) = 1;
+    TREE_PUBLIC(var) = 0;
+    TREE_USED(var) = 1;
+    // execute() passes &counters[i].count to __atomic_fetch_add_8.
+    TREE_ADDRESSABLE(var) = 1;
+    DECL_ARTIFICIAL(var) = 1;
+    DECL_IGNORED_P(var) = 1;
+    DECL_PRESERVE_P(var) = 1;
+    // The runtime walks the section as one array, so forbid the extra
+    // alignment targets like to give large arrays.
+    SET_DECL_ALIGN(var, TYPE_ALIGN(counter_type));
+    DECL_USER_ALIGN(var) = 1;
+
+    vec<constructor_elt, va_gc> *elements = NULL;
+    basic_block bb;
+    FOR_EACH_BB_FN(bb, func) {
+        vec<constructor_elt, va_gc> *fields = NULL;
+        CONSTRUCTOR_APPEND_ELT(fields, count_field, build_int_cst(long_long_unsigned_type_node, 0));
+        CONSTRUCTOR_APPEND_ELT(fields, function_field,
+                               fold_convert(TREE_TYPE(function_field),
+                                            build_string_literal(strlen(name) + 1, name)));
+        CONSTRUCTOR_APPEND_ELT(fields, index_field, build_int_cst(long_long_integer_type_node, bb->index));
+        CONSTRUCTOR_APPEND_ELT(elements, NULL_TREE, build_constructor(counter_type, fields));
+    }
+    DECL_INITIAL(var) = build_constructor(array_type, elements);
+    set_decl_section_name(var, BB_COUNTER_SECTION);
+    varpool_node::finalize_decl(var);
+    return var;
+}
+
+unsigned int bb_counter_pass::execute(function *func) {
+    tree fetch_add = builtin_decl_explicit(BUILT_IN_ATOMIC_FETCH_ADD_8);
+    if (!fetch_add) {
+        warning(0, "gimple_print: __atomic_fetch_add_8 is unavailable, %s is not instrumented", function_name(func));
+        return 0;
+    }
+    if (!counter_type) {
+        build_counter_type();
+    }
+
+    tree counters = build_counters(func, n_basic_blocks_for_fn(func) - 2);
+    tree one = build_int_cst(long_long_unsigned_type_node, 1);
+    tree relaxed = build_int_cst(integer_type_node, MEMMODEL_RELAXED);
+    int i = 0;
+    basic_block bb;
+    FOR_EACH_BB_FN(bb, func) {
+        tree element = build4(ARRAY_REF, counter_type, counters, build_int_cst(integer_type_node, i++),
+                              NULL_TREE, NULL_TREE);
+        tree count = build3(COMPONENT_REF, long_long_unsigned_type_node, element, count_field, NULL_TREE);
+        gcall *call = gimple_build_call(fetch_add, 3, build_fold_addr_expr(count), one, relaxed);
+        gimple_stmt_iterator gsi = gsi_after_labels(bb);
+        gsi_insert_before(&gsi, call, GSI_NEW_STMT);
+    }
+    mark_virtual_operands_for_renaming(func);
+    return 0;
+}
+
+void register_bb_counter_roots(const char *plugin_name) {
+    register_callback(plugin_name, PLUGIN_REGISTER_GGC_ROOTS, NULL, const_cast<ggc_root_tab *>(bb_counter_roots));
+}
+
+gimple_opt_pass *make_bb_counter_pass(gcc::context *ctx, const function_filter *filter) {
+    return new bb_counter_pass(ctx, filter);
+}
@@ -0,0 +1,24 @@
+#ifndef BB_COUNTER_PASS_H
+#define BB_COUNTER_PASS_H
+
+#include "gcc-plugin.h"
+#include "tree-pass.h"
+
+class function_filter;
+
+// Name of the section holding the counter records. The linker provides
+// __start_/__stop_ symbols for it, which bb_counters_runtime.c walks.
+#define BB_COUNTER_SECTION "gimple_print_counters"
+
+// Transforming pass that adds a relaxed atomic increment of a per-block
+// counter to every block of the functions selected by filter. Each
+// function gets a static array of {count, function name, bb->index}
+// records in BB_COUNTER_SECTION; the linker concatenates them into the
+// one array the runtime walks.
+gimple_opt_pass *make_bb_counter_pass(gcc::context *ctx, const function_filter *filter);
+
+// Registers the GC roots for the trees the pass caches across functions.
+// Call from plugin_init before the pass runs.
+void register_bb_counter_roots(const char *plugin_name);
+
+#endif
@@ -0,0 +1,40 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+/* Runtime part of -fplugin-arg-gimple_print-instrument: link it into the
+ * instrumented program. Records are laid out by bb_counter_pass.cpp; each
+ * instrumented function contributes one array to the section. */
+
+struct gimple_print_counter {
+    unsigned long long count;
+    const char *function;
+    long long bb;
+};
+
+extern struct gimple_print_counter __start_gimple_print_counters[] __attribute__((weak));
+extern struct gimple_print_counter __stop_gimple_print_counters[] __attribute__((weak));
+
+/* Writes "function bb count" lines, the same function names and bb->index
+ * values as the plugin's CFG dump, to $GIMPLE_PRINT_COUNTERS or
+ * bb_counters.txt. */
+__attribute__((destructor)) static void gimple_print_dump_counters(void) {
+    const char *path = getenv("GIMPLE_PRINT_COUNTERS");
+    FILE *file;
+    struct gimple_print_counter *counter;
+
+    if (!__start_gimple_print_counters) {
+        return;
+    }
+    file = fopen(path ? path : "bb_counters.txt", "a");
+    if (!file) {
+        perror("gimple_print counters");
+        return;
+    }
+    for (counter = __start_gimple_print_counters; counter < __stop_gimple_print_counters; ++counter) {
+        /* Skip padding the linker may leave between arrays. */
+        if (counter->function) {
+            fprintf(file, "%s %lld %llu\n", counter->function, counter->bb, counter->count);
+        }
+    }
+    fclose(file);
+}
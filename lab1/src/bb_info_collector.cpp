@@ -1,207 +1,379 @@
+#include <charconv>
+#include <cstdio>
 #include <iostream>
-#include <regex>
 
 #include "gcc-plugin.h"
 #include "tree.h"
 #include "gimple.h"
+#include "internal-fn.h"
 #include "bb_info_collector.h"
 
-void bb_info_collector::print_graphviz() {
-    std::string copy = this->s;
-    copy = std::regex_replace(copy, std::regex("\n"), "\\n");
-    std::cout << this->id << "[label=\"" << copy << "\"]" << std::endl;
-    for (int id : this->adjacent) {
-        std::cout << this->id << "->" << id << std::endl;
-    }
-}
-
-bb_info_collector::bb_info_collector(int id) {
-    this->id = id;
+static void append_number(std::string &out, long long value) {
+    char buf[24];
+    auto res = std::to_chars(buf, buf + sizeof(buf), value);
+    out.append(buf, res.ptr);
 }
 
-void bb_info_collector::add_adjacent(int id) {
-    this->adjacent.push_back(id);
+static void append_unsigned(std::string &out, unsigned long long value) {
+    char buf[24];
+    auto res = std::to_chars(buf, buf + sizeof(buf), value);
+    out.append(buf, res.ptr);
 }
 
-void bb_info_collector::add_string(std::string info) {
-    this->s.append(info);
-}
-
-void bb_info_collector::add_op(tree_code op) {
+static void append_op(std::string &out, tree_code op) {
     switch (op) {
         case LE_EXPR:
-            this->add_string("<=");
+            out.append("<=");
             break;
         case LT_EXPR:
-            this->add_string("<");
+            out.append("<");
             break;
         case GE_EXPR:
-            this->add_string(">=");
+            out.append(">=");
             break;
         case GT_EXPR:
-            this->add_string(">");
+            out.append(">");
             break;
         case EQ_EXPR:
-            this->add_string("==");
+            out.append("==");
             break;
         case PLUS_EXPR:
-            this->add_string("+");
+            out.append("+");
             break;
         case MINUS_EXPR:
-            this->add_string("-");
+            out.append("-");
             break;
         case MULT_EXPR:
-            this->add_string("*");
+            out.append("*");
             break;
         case FLOOR_DIV_EXPR:
         case EXACT_DIV_EXPR:
         case CEIL_DIV_EXPR:
         case ROUND_DIV_EXPR:
-            this->add_string("/");
+            out.append("/");
             break;
         case FLOOR_MOD_EXPR:
         case TRUNC_MOD_EXPR:
         case CEIL_MOD_EXPR:
         case ROUND_MOD_EXPR:
-            this->add_string("%");
+            out.append("%");
             break;
         default:
-            this->add_string("<");
-            this->add_string(std::to_string(op));
-            this->add_string(">");
+            out.append("<");
+            append_number(out, op);
+            out.append(">");
             break;
     }
 }
 
+bb_info_collector::bb_info_collector(int id) {
+    this->id = id;
+    this->annotations = {-1, -1, 0, 0, 0};
+}
+
+void bb_info_collector::set_annotations(const block_annotations &annotations) {
+    this->annotations = annotations;
+}
+
+void bb_info_collector::add_adjacent(int id, int flags, int probability) {
+    this->adjacent.push_back({id, flags, probability});
+}
+
+void bb_info_collector::add_operand(operand_kind kind, const char *name, long long value) {
+    uint32_t offset = OPERAND_NO_NAME;
+    if (name) {
+        offset = this->names.size();
+        this->names.append(name);
+        this->names.push_back('\0');
+    }
+    this->operands.push_back({kind, 0, offset, value});
+}
+
 void bb_info_collector::add_tree(tree t) {
     tree_code code = TREE_CODE(t);
     switch (code) {
         case CONSTRUCTOR:
-            this->add_string("constructor");
+            this->add_operand(OPERAND_CONSTRUCTOR);
             break;
         case INTEGER_CST:
-            this->add_string(std::to_string(TREE_INT_CST_LOW(t)));
+            this->add_operand(OPERAND_CONSTANT, nullptr, TREE_INT_CST_LOW(t));
             break;
         case VAR_DECL:
         case CONST_DECL:
         case PARM_DECL:
         case FUNCTION_DECL:
         case LABEL_DECL:
-            this->add_string(IDENTIFIER_POINTER(DECL_NAME(t)));
+            this->add_operand(OPERAND_NAME, DECL_NAME(t) ? IDENTIFIER_POINTER(DECL_NAME(t)) : nullptr);
             break;
         case FUNCTION_TYPE:
-            this->add_string("FUNC");
+            this->add_operand(OPERAND_FUNC_TYPE);
             break;
         case ARRAY_TYPE:
-            this->add_string("ARRAY");
+            this->add_operand(OPERAND_ARRAY_TYPE);
             break;
         case INTEGER_TYPE:
-            this->add_string("INT");
+            this->add_operand(OPERAND_INT_TYPE);
             break;
         case ADDR_EXPR:
-            this->add_string("&");
+            this->add_operand(OPERAND_ADDR);
             this->add_tree(TREE_TYPE(t));
             break;
         case POINTER_TYPE:
-            this->add_string("*");
+            this->add_operand(OPERAND_POINTER);
             this->add_tree(TREE_TYPE(t));
             break;
         case SSA_NAME: {
-            gimple *stmt = SSA_NAME_DEF_STMT(t);
-            if (gimple_code(stmt) == GIMPLE_PHI) {
-                this->add_string("PHI(");
-                int args = gimple_phi_num_args(stmt);
-                for (int i = 0; i < args; ++i) {
-                    this->add_tree(gimple_phi_arg(stmt, i)->def);
-                    if (i != args - 1) {
-                        this->add_string(",");
-                    }
-                }
-                this->add_string(")");
-            } else {
-                tree ident = SSA_NAME_IDENTIFIER(t);
-                this->add_string(ident ? IDENTIFIER_POINTER(ident) : "unnamed_var");
-                this->add_string(std::to_string(SSA_NAME_VERSION(t)));
-            }
+            tree ident = SSA_NAME_IDENTIFIER(t);
+            this->add_operand(OPERAND_SSA, ident ? IDENTIFIER_POINTER(ident) : nullptr, SSA_NAME_VERSION(t));
             break;
         }
         case ARRAY_REF:
-            this->add_string("ARRAY[");
+            this->add_operand(OPERAND_ARRAY_REF);
             this->add_tree(TREE_TYPE(t));
-            this->add_string("]");
             break;
         default:
-            this->add_string("(");
-            this->add_string(std::to_string(code));
-            this->add_string(")");
+            this->add_operand(OPERAND_OTHER, nullptr, code);
     }
 }
 
 void bb_info_collector::add_gimple_assign(gimple *stmt) {
-    this->add_string("ASSIGN ");
     switch (gimple_num_ops(stmt)) {
         case 2:
             this->add_tree(gimple_assign_lhs(stmt));
-            this->add_string(" = ");
             this->add_tree(gimple_assign_rhs1(stmt));
             break;
         case 3:
             this->add_tree(gimple_assign_lhs(stmt));
-            this->add_string(" = ");
             this->add_tree(gimple_assign_rhs1(stmt));
-            this->add_string(" ");
-            this->add_op(gimple_assign_rhs_code(stmt));
-            this->add_string(" ");
             this->add_tree(gimple_assign_rhs2(stmt));
             break;
     }
 }
 
 void bb_info_collector::add_gimple_call(gimple *stmt) {
-    this->add_tree(gimple_call_fn(stmt));
-    this->add_string("(");
+    tree fn = gimple_call_fn(stmt);
+    if (fn) {
+        this->add_tree(fn);
+    } else {
+        this->add_operand(OPERAND_NAME, internal_fn_name(gimple_call_internal_fn(stmt)));
+    }
     int args = gimple_call_num_args(stmt);
     for (int i = 0; i < args; ++i) {
         this->add_tree(gimple_call_arg(stmt, i));
-        if (i != args - 1) {
-            this->add_string(",");
-        }
     }
-    this->add_string(")");
 }
 
 void bb_info_collector::add_gimple_cond(gimple *stmt) {
-    this->add_string("COND ");
     this->add_tree(gimple_cond_lhs(stmt));
-    this->add_string(" ");
-    this->add_op(gimple_cond_code(stmt));
-    this->add_string(" ");
     this->add_tree(gimple_cond_rhs(stmt));
 }
 
 void bb_info_collector::add_statement(gimple *stmt) {
+    stmt_record record = {(unsigned short) gimple_code(stmt), 0, (unsigned int) this->operands.size(), 0};
     switch (gimple_code(stmt)) {
         case GIMPLE_ASSIGN:
+            record.op = gimple_assign_rhs_code(stmt);
+            record.num_operands = gimple_num_ops(stmt) == 2 || gimple_num_ops(stmt) == 3 ? gimple_num_ops(stmt) : 0;
             this->add_gimple_assign(stmt);
             break;
         case GIMPLE_CALL:
+            record.num_operands = 1 + gimple_call_num_args(stmt);
             this->add_gimple_call(stmt);
             break;
         case GIMPLE_COND:
+            record.op = gimple_cond_code(stmt);
+            record.num_operands = 2;
             this->add_gimple_cond(stmt);
             break;
+        default:
+            break;
+    }
+    this->stmts.push_back(record);
+}
+
+void bb_info_collector::add_phi(gphi *phi) {
+    int args = gimple_phi_num_args(phi);
+    this->stmts.push_back({GIMPLE_PHI, 0, (unsigned int) this->operands.size(), 2});
+    this->add_tree(gimple_phi_result(phi));
+    size_t pos = this->operands.size();
+    this->add_operand(OPERAND_PHI);
+    this->operands[pos].arity = args;
+    for (int i = 0; i < args; ++i) {
+        edge e = gimple_phi_arg_edge(phi, i);
+        pos = this->operands.size();
+        this->add_operand(e->flags & EDGE_DFS_BACK ? OPERAND_PHI_BACK_ARG : OPERAND_PHI_ARG, nullptr, e->src->index);
+        this->operands[pos].arity = 1;
+        this->add_tree(gimple_phi_arg_def(phi, i));
+    }
+}
+
+size_t bb_info_collector::render_operand(std::string &out, size_t pos) const {
+    const operand_record &operand = this->operands[pos++];
+    switch (operand.kind) {
+        case OPERAND_CONSTANT:
+            append_unsigned(out, operand.value);
+            break;
+        case OPERAND_NAME:
+            out.append(operand.name != OPERAND_NO_NAME ? this->get_name(operand) : "unnamed_var");
+            break;
+        case OPERAND_SSA:
+            out.append(operand.name != OPERAND_NO_NAME ? this->get_name(operand) : "unnamed_var");
+            append_number(out, operand.value);
+            break;
+        case OPERAND_PHI:
+            out.append("PHI(");
+            for (int i = 0; i < operand.arity; ++i) {
+                pos = this->render_operand(out, pos);
+                if (i != operand.arity - 1) {
+                    out.append(",");
+                }
+            }
+            out.append(")");
+            break;
+        case OPERAND_PHI_ARG:
+        case OPERAND_PHI_BACK_ARG:
+            pos = this->render_operand(out, pos);
+            out.append(" [bb ");
+            append_number(out, operand.value);
+            out.append(operand.kind == OPERAND_PHI_BACK_ARG ? " back]" : "]");
+            break;
+        case OPERAND_ADDR:
+            out.append("&");
+            pos = this->render_operand(out, pos);
+            break;
+        case OPERAND_POINTER:
+            out.append("*");
+            pos = this->render_operand(out, pos);
+            break;
+        case OPERAND_ARRAY_REF:
+            out.append("ARRAY[");
+            pos = this->render_operand(out, pos);
+            out.append("]");
+            break;
+        case OPERAND_CONSTRUCTOR:
+            out.append("constructor");
+            break;
+        case OPERAND_FUNC_TYPE:
+            out.append("FUNC");
+            break;
+        case OPERAND_ARRAY_TYPE:
+            out.append("ARRAY");
+            break;
+        case OPERAND_INT_TYPE:
+            out.append("INT");
+            break;
+        case OPERAND_OTHER:
+            out.append("(");
+            append_number(out, operand.value);
+            out.append(")");
+            break;
+    }
+    return pos;
+}
+
+void bb_info_collector::render_statement(std::string &out, const stmt_record &stmt) const {
+    size_t pos = stmt.first_operand;
+    switch (stmt.code) {
+        case GIMPLE_ASSIGN:
+            out.append("ASSIGN ");
+            if (stmt.num_operands == 0) {
+                break;
+            }
+            pos = this->render_operand(out, pos);
+            out.append(" = ");
+            pos = this->render_operand(out, pos);
+            if (stmt.num_operands == 3) {
+                out.append(" ");
+                append_op(out, (tree_code) stmt.op);
+                out.append(" ");
+                this->render_operand(out, pos);
+            }
+            break;
+        case GIMPLE_CALL:
+            pos = this->render_operand(out, pos);
+            out.append("(");
+            for (unsigned int i = 1; i < stmt.num_operands; ++i) {
+                pos = this->render_operand(out, pos);
+                if (i != stmt.num_operands - 1) {
+                    out.append(",");
+                }
+            }
+            out.append(")");
+            break;
+        case GIMPLE_COND:
+            out.append("COND ");
+            pos = this->render_operand(out, pos);
+            out.append(" ");
+            append_op(out, (tree_code) stmt.op);
+            out.append(" ");
+            this->render_operand(out, pos);
+            break;
         case GIMPLE_RETURN:
-            this->add_string("RETURN");
+            out.append("RETURN");
             break;
         case GIMPLE_LABEL:
-            this->add_string("LABEL");
+            out.append("LABEL");
             break;
         case GIMPLE_PHI:
-            this->add_string("PHI");
+            out.append("PHI ");
+            pos = this->render_operand(out, pos);
+            out.append(" = ");
+            this->render_operand(out, pos);
             break;
         default:
-            this->add_string("Unknown statement: " + std::to_string(gimple_code(stmt)));
+            out.append("Unknown statement: ");
+            append_number(out, stmt.code);
     }
-    this->add_string("\n");
 }
 
+static void append_heat_color(std::string &out, long long count, long long max_count) {
+    char buf[32];
+    double heat = count > 0 && max_count > 0 ? (double) count / max_count : 0;
+    snprintf(buf, sizeof(buf), "0.000 %.3f 1.000", heat);
+    out.append(buf);
+}
+
+void bb_info_collector::render_graphviz(std::string &out, bool annotated, long long max_count) const {
+    const block_annotations &a = this->annotations;
+    append_number(out, this->id);
+    out.append("[label=\"");
+    if (annotated) {
+        out.append("count=");
+        append_number(out, a.count);
+        out.append(" cost=");
+        append_number(out, a.cost);
+        out.append(" depth=");
+        append_number(out, a.loop_depth);
+        if (a.loop_flags & BLOCK_LOOP_HEADER) {
+            out.append(" header");
+        }
+        if (a.loop_flags & BLOCK_LOOP_LATCH) {
+            out.append(" latch");
+        }
+        out.append(" idom=");
+        append_number(out, a.idom);
+        out.append("\\n");
+    }
+    for (const stmt_record &stmt : this->stmts) {
+        this->render_statement(out, stmt);
+        out.append("\\n");
+    }
+    out.append("\"");
+    if (annotated) {
+        out.append(" style=filled fillcolor=\"");
+        append_heat_color(out, a.count, max_count);
+        out.append("\"");
+    }
+    out.append("]\n");
+    for (const edge_record &e : this->adjacent) {
+        append_number(out, this->id);
+        out.append("->");
+        append_number(out, e.dest);
+        if (annotated && e.probability >= 0) {
+            char buf[32];
+            snprintf(buf, sizeof(buf), "[label=\"%.1f%%\"]", e.probability / 100.0);
+            out.append(buf);
+        }
+        out.append("\n");
+    }
+}
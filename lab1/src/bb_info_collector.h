@@ -1,30 +1,110 @@
 #ifndef BB_INFO_COLLECTOR_H
 #define BB_INFO_COLLECTOR_H
 
+#include <cstdint>
 #include <iostream>
+#include <string>
 #include <vector>
 
 #include "gcc-plugin.h"
 
+enum operand_kind : unsigned char {
+    OPERAND_CONSTANT,     // value = TREE_INT_CST_LOW
+    OPERAND_NAME,         // name = declaration identifier
+    OPERAND_SSA,          // name = identifier or null, value = SSA_NAME_VERSION
+    OPERAND_PHI,          // arity = number of PHI arguments, followed by them
+    OPERAND_PHI_ARG,      // value = source block index, followed by one operand
+    OPERAND_PHI_BACK_ARG, // OPERAND_PHI_ARG over a DFS back edge
+    OPERAND_ADDR,         // "&", followed by one operand
+    OPERAND_POINTER,      // "*", followed by one operand
+    OPERAND_ARRAY_REF,    // "ARRAY[...]", followed by one operand
+    OPERAND_CONSTRUCTOR,
+    OPERAND_FUNC_TYPE,
+    OPERAND_ARRAY_TYPE,
+    OPERAND_INT_TYPE,
+    OPERAND_OTHER,        // value = tree_code
+};
+
+#define OPERAND_NO_NAME UINT32_MAX
+
+// Operands are stored in prefix order: a composite operand is followed
+// by its `arity` children. A PHI is recorded once, as a GIMPLE_PHI
+// statement of its block; uses of its result are plain OPERAND_SSA names.
+// Names are copied into the collector, since the records outlive the GC
+// strings they come from and are read by the writer thread.
+struct operand_record {
+    operand_kind kind;
+    unsigned short arity;
+    uint32_t name;  // offset into the collector's names, or OPERAND_NO_NAME
+    long long value;
+};
+
+struct stmt_record {
+    unsigned short code;  // gimple_code
+    unsigned short op;    // tree_code of the operation, if any
+    unsigned int first_operand;
+    unsigned int num_operands;
+};
+
+struct edge_record {
+    int dest;         // dest->index
+    int flags;        // e->flags
+    int probability;  // out of REG_BR_PROB_BASE, -1 if unknown
+};
+
+enum block_loop_flags {
+    BLOCK_LOOP_HEADER = 1,
+    BLOCK_LOOP_LATCH = 2,
+};
+
+// Profile and CFG annotations, filled in when the plugin runs with `annotate`.
+struct block_annotations {
+    long long count;  // bb->count, -1 if unknown
+    int idom;         // index of the immediate dominator, -1 if none
+    int loop_depth;
+    int loop_flags;   // block_loop_flags
+    int cost;         // estimate_num_insns over the block with eni_time_weights
+};
+
 class bb_info_collector {
 private:
     int id;
-    std::string s;
-    std::vector<int> adjacent;
+    std::vector<stmt_record> stmts;
+    std::vector<operand_record> operands;
+    std::string names;  // NUL-terminated operand names
+    std::vector<edge_record> adjacent;
+    block_annotations annotations;
 
     void add_gimple_assign(gimple *stmt);
     void add_gimple_call(gimple *stmt);
     void add_gimple_cond(gimple *stmt);
     void add_tree(tree t);
-    void add_op(tree_code op);
-    void add_string(std::string info);
+    void add_operand(operand_kind kind, const char *name = nullptr, long long value = 0);
+
+    size_t render_operand(std::string &out, size_t pos) const;
+    void render_statement(std::string &out, const stmt_record &stmt) const;
 
 public:
     bb_info_collector(int id);
+    bb_info_collector(bb_info_collector &&other) = default;
+    bb_info_collector &operator=(bb_info_collector &&other) = default;
 
     void add_statement(gimple *stmt);
-    void add_adjacent(int id);
-    void print_graphviz();
+    // Needs EDGE_DFS_BACK from mark_dfs_back_edges to flag back edges.
+    void add_phi(gphi *phi);
+    void add_adjacent(int id, int flags, int probability);
+    void set_annotations(const block_annotations &annotations);
+    // Annotated output colors the block by count relative to max_count.
+    void render_graphviz(std::string &out, bool annotated = false, long long max_count = 0) const;
+
+    int get_id() const { return this->id; }
+    const std::vector<stmt_record> &get_statements() const { return this->stmts; }
+    const std::vector<operand_record> &get_operands() const { return this->operands; }
+    const char *get_name(const operand_record &operand) const {
+        return operand.name == OPERAND_NO_NAME ? nullptr : this->names.c_str() + operand.name;
+    }
+    const std::vector<edge_record> &get_adjacent() const { return this->adjacent; }
+    const block_annotations &get_annotations() const { return this->annotations; }
 };
 
 #endif
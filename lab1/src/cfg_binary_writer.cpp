@@ -0,0 +1,55 @@
+#include "cfg_binary_writer.h"
+
+void cfg_binary_writer::begin_unit(const char *name, const char *compiler) {
+    cfg_unit unit = {};
+    unit.name = this->tables.add_string(name);
+    unit.compiler = this->tables.add_string(compiler);
+    unit.first_function = this->tables.functions.size();
+    this->tables.units.push_back(unit);
+}
+
+void cfg_binary_writer::add_function(const char *name, const std::vector<bb_info_collector> &bbs) {
+    cfg_tables &t = this->tables;
+    uint32_t function_id = t.functions.size();
+    uint32_t first_block = t.blocks.size();
+    t.functions.push_back({t.add_string(name), (uint32_t) t.units.size() - 1, first_block, (uint32_t) bbs.size()});
+    t.units.back().num_functions++;
+
+    // Edges refer to blocks by position in the file, so map bb->index first.
+    this->block_ids.clear();
+    for (size_t i = 0; i < bbs.size(); ++i) {
+        int index = bbs[i].get_id();
+        if (index >= (int) this->block_ids.size()) {
+            this->block_ids.resize(index + 1, -1);
+        }
+        this->block_ids[index] = first_block + i;
+    }
+
+    for (size_t i = 0; i < bbs.size(); ++i) {
+        const bb_info_collector &bb = bbs[i];
+        const std::vector<stmt_record> &stmts = bb.get_statements();
+        const std::vector<operand_record> &operands = bb.get_operands();
+        const std::vector<edge_record> &adjacent = bb.get_adjacent();
+        const block_annotations &a = bb.get_annotations();
+        uint32_t operand_base = t.operands.size();
+
+        t.blocks.push_back({bb.get_id(), function_id, (uint32_t) t.stmts.size(), (uint32_t) stmts.size(),
+                            (uint32_t) t.edges.size(), (uint32_t) adjacent.size(), a.count, a.idom,
+                            (uint32_t) a.cost, (uint16_t) a.loop_depth, (uint16_t) a.loop_flags, 0});
+        for (const stmt_record &stmt : stmts) {
+            t.stmts.push_back({stmt.code, stmt.op, operand_base + stmt.first_operand, stmt.num_operands});
+        }
+        for (const operand_record &operand : operands) {
+            t.operands.push_back({operand.kind, 0, operand.arity, t.add_string(bb.get_name(operand)),
+                                  operand.value});
+        }
+        for (const edge_record &e : adjacent) {
+            int dest = e.dest < (int) this->block_ids.size() ? this->block_ids[e.dest] : -1;
+            t.edges.push_back({first_block + (uint32_t) i, (uint32_t) dest, (uint32_t) e.flags, e.probability});
+        }
+    }
+}
+
+bool cfg_binary_writer::write(const char *path) const {
+    return this->tables.write(path);
+}
@@ -0,0 +1,22 @@
+#ifndef CFG_BINARY_WRITER_H
+#define CFG_BINARY_WRITER_H
+
+#include <vector>
+
+#include "cfg_tables.h"
+#include "bb_info_collector.h"
+
+// Accumulates the functions of one translation unit and writes them as
+// a binary CFG file (see cfg_format.h) when compilation finishes.
+class cfg_binary_writer {
+private:
+    cfg_tables tables;
+    std::vector<int> block_ids;
+
+public:
+    void begin_unit(const char *name, const char *compiler);
+    void add_function(const char *name, const std::vector<bb_info_collector> &bbs);
+    bool write(const char *path) const;
+};
+
+#endif
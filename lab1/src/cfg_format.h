@@ -0,0 +1,93 @@
+#ifndef CFG_FORMAT_H
+#define CFG_FORMAT_H
+
+#include <cstdint>
+
+// On-disk layout of the binary CFG export (`-fplugin-arg-gimple_print-format=bin`).
+// The file is a header followed by 8-byte aligned tables of fixed-size
+// little-endian records, so a reader can mmap it and use the tables as is.
+// String references are byte offsets into the string table; indices into
+// other tables are positions in the whole file, not per function.
+
+#define CFG_FORMAT_MAGIC "GPCFGBIN"
+#define CFG_FORMAT_VERSION 3
+#define CFG_NO_STRING UINT32_MAX
+
+enum cfg_section {
+    CFG_SECTION_STRINGS,        // NUL-terminated strings, count = bytes
+    CFG_SECTION_UNITS,          // cfg_unit
+    CFG_SECTION_FUNCTIONS,      // cfg_function
+    CFG_SECTION_FUNCTION_INDEX, // uint32_t function ids sorted by name
+    CFG_SECTION_BLOCKS,         // cfg_block
+    CFG_SECTION_EDGES,          // cfg_edge
+    CFG_SECTION_STMTS,          // cfg_stmt
+    CFG_SECTION_OPERANDS,       // cfg_operand
+    CFG_SECTION_COUNT,
+};
+
+struct cfg_section_entry {
+    uint64_t offset;
+    uint64_t count;
+};
+
+struct cfg_header {
+    char magic[8];
+    uint32_t version;
+    uint32_t num_sections;
+    cfg_section_entry sections[CFG_SECTION_COUNT];
+};
+
+// One translation unit.
+struct cfg_unit {
+    uint32_t name;
+    uint32_t compiler;
+    uint32_t first_function;
+    uint32_t num_functions;
+};
+
+struct cfg_function {
+    uint32_t name;
+    uint32_t unit;
+    uint32_t first_block;
+    uint32_t num_blocks;
+};
+
+struct cfg_block {
+    int32_t index;  // bb->index
+    uint32_t function;
+    uint32_t first_stmt;
+    uint32_t num_stmts;
+    uint32_t first_edge;
+    uint32_t num_edges;
+    int64_t count;        // bb->count, -1 if unknown
+    int32_t idom;         // bb->index of the immediate dominator, -1 if none
+    uint32_t cost;        // estimate_num_insns with eni_time_weights
+    uint16_t loop_depth;
+    uint16_t loop_flags;  // BLOCK_LOOP_* from bb_info_collector.h
+    uint32_t reserved;
+};
+
+struct cfg_edge {
+    uint32_t src;
+    uint32_t dest;
+    uint32_t flags;       // e->flags
+    int32_t probability;  // out of REG_BR_PROB_BASE (10000), -1 if unknown
+};
+
+struct cfg_stmt {
+    uint16_t code;  // gimple_code
+    uint16_t op;    // tree_code
+    uint32_t first_operand;
+    uint32_t num_operands;
+};
+
+// Same prefix encoding as operand_record in bb_info_collector.h.
+struct cfg_operand {
+    uint8_t kind;
+    uint8_t reserved;
+    uint16_t arity;
+    uint32_t name;
+    int64_t value;
+};
+
+#endif
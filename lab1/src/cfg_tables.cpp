@@ -0,0 +1,88 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#include "cfg_tables.h"
+
+uint32_t cfg_tables::add_string(const char *s) {
+    if (!s) {
+        return CFG_NO_STRING;
+    }
+    return this->add_string(s, strlen(s));
+}
+
+uint32_t cfg_tables::add_string(const char *s, size_t len) {
+    auto it = this->string_ids.emplace(std::string(s, len), (uint32_t) this->strings.size());
+    if (it.second) {
+        this->strings.insert(this->strings.end(), s, s + len);
+        this->strings.push_back('\0');
+    }
+    return it.first->second;
+}
+
+static uint64_t align8(uint64_t offset) {
+    return (offset + 7) & ~(uint64_t) 7;
+}
+
+template <class T>
+static void place(cfg_header &header, uint64_t &offset, cfg_section section, const std::vector<T> &table) {
+    offset = align8(offset);
+    header.sections[section].offset = offset;
+    header.sections[section].count = table.size();
+    offset += table.size() * sizeof(T);
+}
+
+template <class T>
+static bool emit(FILE *file, const cfg_header &header, uint64_t &offset, cfg_section section, const std::vector<T> &table) {
+    static const char zeros[8] = {};
+    uint64_t padding = header.sections[section].offset - offset;
+    if (padding && fwrite(zeros, 1, padding, file) != padding) {
+        return false;
+    }
+    offset = header.sections[section].offset + table.size() * sizeof(T);
+    return table.empty() || fwrite(table.data(), sizeof(T), table.size(), file) == table.size();
+}
+
+bool cfg_tables::write(const char *path) const {
+    std::vector<uint32_t> index(this->functions.size());
+    for (uint32_t i = 0; i < index.size(); ++i) {
+        index[i] = i;
+    }
+    std::sort(index.begin(), index.end(), [this](uint32_t a, uint32_t b) {
+        uint32_t na = this->functions[a].name, nb = this->functions[b].name;
+        if (na == CFG_NO_STRING || nb == CFG_NO_STRING) {
+            return na != CFG_NO_STRING && nb == CFG_NO_STRING;
+        }
+        return strcmp(&this->strings[na], &this->strings[nb]) < 0;
+    });
+
+    cfg_header header = {};
+    memcpy(header.magic, CFG_FORMAT_MAGIC, sizeof(header.magic));
+    header.version = CFG_FORMAT_VERSION;
+    header.num_sections = CFG_SECTION_COUNT;
+    uint64_t offset = sizeof(header);
+    place(header, offset, CFG_SECTION_STRINGS, this->strings);
+    place(header, offset, CFG_SECTION_UNITS, this->units);
+    place(header, offset, CFG_SECTION_FUNCTIONS, this->functions);
+    place(header, offset, CFG_SECTION_FUNCTION_INDEX, index);
+    place(header, offset, CFG_SECTION_BLOCKS, this->blocks);
+    place(header, offset, CFG_SECTION_EDGES, this->edges);
+    place(header, offset, CFG_SECTION_STMTS, this->stmts);
+    place(header, offset, CFG_SECTION_OPERANDS, this->operands);
+
+    FILE *file = fopen(path, "wb");
+    if (!file) {
+        return false;
+    }
+    offset = sizeof(header);
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1
+        && emit(file, header, offset, CFG_SECTION_STRINGS, this->strings)
+        && emit(file, header, offset, CFG_SECTION_UNITS, this->units)
+        && emit(file, header, offset, CFG_SECTION_FUNCTIONS, this->functions)
+        && emit(file, header, offset, CFG_SECTION_FUNCTION_INDEX, index)
+        && emit(file, header, offset, CFG_SECTION_BLOCKS, this->blocks)
+        && emit(file, header, offset, CFG_SECTION_EDGES, this->edges)
+        && emit(file, header, offset, CFG_SECTION_STMTS, this->stmts)
+        && emit(file, header, offset, CFG_SECTION_OPERANDS, this->operands);
+    return fclose(file) == 0 && ok;
+}
@@ -0,0 +1,30 @@
+#ifndef CFG_TABLES_H
+#define CFG_TABLES_H
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "cfg_format.h"
+
+// In-memory tables of a binary CFG file, shared by the plugin writer and
+// the merge tool.
+class cfg_tables {
+private:
+    std::unordered_map<std::string, uint32_t> string_ids;
+
+public:
+    std::vector<char> strings;
+    std::vector<cfg_unit> units;
+    std::vector<cfg_function> functions;
+    std::vector<cfg_block> blocks;
+    std::vector<cfg_edge> edges;
+    std::vector<cfg_stmt> stmts;
+    std::vector<cfg_operand> operands;
+
+    uint32_t add_string(const char *s);
+    uint32_t add_string(const char *s, size_t len);
+    bool write(const char *path) const;
+};
+
+#endif
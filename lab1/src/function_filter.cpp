@@ -0,0 +1,42 @@
+#include <cstring>
+
+#include "function_filter.h"
+
+void function_filter::add_names(const char *list) {
+    while (*list) {
+        const char *end = strchr(list, ',');
+        size_t len = end ? end - list : strlen(list);
+        if (len) {
+            this->names.emplace(list, len);
+        }
+        list += end ? len + 1 : len;
+    }
+}
+
+bool function_filter::add_pattern(const char *pattern) {
+    try {
+        this->patterns.emplace_back(pattern, std::regex::ECMAScript | std::regex::optimize);
+    } catch (const std::regex_error &) {
+        return false;
+    }
+    return true;
+}
+
+bool function_filter::empty() const {
+    return this->names.empty() && this->patterns.empty();
+}
+
+bool function_filter::matches(const char *name) const {
+    if (this->empty()) {
+        return true;
+    }
+    if (this->names.count(name)) {
+        return true;
+    }
+    for (const std::regex &pattern : this->patterns) {
+        if (std::regex_search(name, pattern)) {
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,23 @@
+#ifndef FUNCTION_FILTER_H
+#define FUNCTION_FILTER_H
+
+#include <regex>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+// Selects functions by exact name or by regex; an empty filter matches
+// every function.
+class function_filter {
+private:
+    std::unordered_set<std::string> names;
+    std::vector<std::regex> patterns;
+
+public:
+    void add_names(const char *list);
+    bool add_pattern(const char *pattern);
+    bool empty() const;
+    bool matches(const char *name) const;
+};
+
+#endif
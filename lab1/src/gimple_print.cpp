@@ -1,4 +1,8 @@
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
+#include <memory>
+#include <string>
 #include <vector>
 
 #include "gcc-plugin.h"
@@ -7,58 +11,277 @@
 #include "context.h"
 #include "gimple.h"
 #include "gimple-iterator.h"
+#include "diagnostic-core.h"
+#include "cfgloop.h"
+#include "tree-inline.h"
+#include "cfganal.h"
+#include "ssa.h"
 
 #include "bb_info_collector.h"
+#include "cfg_binary_writer.h"
+#include "function_filter.h"
+#include "async_writer.h"
+#include "stats_collector.h"
+#include "bb_counter_pass.h"
+#include "mod_reduce_pass.h"
+#include "stage_tracker.h"
+#include "pass_profiler.h"
+#include "loop_lint.h"
+#include "gcc_cfg.h"
+#include "dominators.h"
 
 int plugin_is_GPL_compatible = 1;
 
 static struct plugin_info gimple_print_info = {
     .version = "0.1",
-    .help = "This plugin prints GIMPLE",
-}; 
+    .help = "This plugin prints GIMPLE\n"
+            "  format=graphviz|bin  output format (default graphviz, printed to stdout)\n"
+            "  output=PATH          binary output file, or directory if PATH ends with '/'\n"
+            "                       (default <source basename>.cfg)\n"
+            "  function=NAME[,NAME] only dump the named functions (repeatable)\n"
+            "  function-regex=RE    only dump functions whose name matches RE (repeatable)\n"
+            "  output-dir=DIR       write one DIR/<function>.dot file per function\n"
+            "  annotate             add profile counts, edge probabilities, loop depth,\n"
+            "                       loop header/latch, immediate dominator and cost\n"
+            "  hot-report=PATH      write the hottest blocks to PATH (implies annotate)\n"
+            "  ref-pass=NAME[:N]    run after instance N of GIMPLE pass NAME (default ssa:1);\n"
+            "                       use a late pass such as optimized to see profile data\n"
+            "  stats=PATH           only count statements, operators, blocks, edges and PHIs,\n"
+            "                       and merge the totals into the shared file PATH\n"
+            "  instrument           count block executions of the selected functions; link\n"
+            "                       bb_counters_runtime.c to dump them at exit. Disables the\n"
+            "                       CFG dump unless format, output or output-dir is given\n"
+            "  mod-reduce           replace `iv % C` in loops, for a unit-stride signed\n"
+            "                       induction variable iv and constant C, by a counter that\n"
+            "                       wraps at C. Disables the CFG dump like instrument\n"
+            "  stages=NAME[:N],...  snapshot the selected functions after each listed pass\n"
+            "                       (e.g. ssa,cunroll,vect,optimized) and write a diff of\n"
+            "                       blocks, edges, statements, loops and vector statements\n"
+            "                       between stages, down to the blocks added, removed or\n"
+            "                       changed. Disables the CFG dump like instrument\n"
+            "  stage-diff=PATH      write the stage diff to PATH (default stdout)\n"
+            "  profile=PATH         time every pass on every function and write the slowest\n"
+            "                       pass/function pairs and passes to PATH\n"
+            "  profile-trace=PATH   also write the pass timeline as Chrome trace-event JSON\n"
+            "  lint=PATH            append loop performance hazards (calls, memory\n"
+            "                       dependences, variable division, branch chains) as JSON\n"
+            "                       lines to PATH. Disables the CFG dump like instrument",
+};
 
 static struct pass_data gimple_print_pass_data = {
     .type = GIMPLE_PASS,
     .name = "gimple_print",
 };
 
+enum output_format {
+    FORMAT_GRAPHVIZ,
+    FORMAT_BIN,
+};
+
+static output_format format = FORMAT_GRAPHVIZ;
+static std::string output_path;
+static std::string output_dir;
+static std::string compiler_version;
+static bool annotate = false;
+static std::string hot_report_path;
+static std::string ref_pass_name = "ssa";
+static std::string stats_path;
+static stats_collector stats;
+static bool dump = true;
+static bool instrument = false;
+static bool mod_reduce = false;
+static stage_tracker stages;
+static std::string stage_diff_path;
+static pass_profiler profiler;
+static std::string profile_path;
+static std::string profile_trace_path;
+static loop_linter linter;
+static std::string lint_path;
+static function_filter filter;
+static cfg_binary_writer binary_writer;
+static async_writer writer(&binary_writer);
+
 struct gimple_print_pass : gimple_opt_pass {
     gimple_print_pass(gcc::context *ctx): gimple_opt_pass(gimple_print_pass_data, ctx) {}
     virtual gimple_print_pass *clone() override { return this; }
+    virtual bool gate(function *func) override;
     virtual unsigned int execute(function *func) override;
 };
 
-void print_graphviz(const std::vector<bb_info_collector> &bbs) {
-    std::cout << "digraph G {" << std::endl; 
-    std::cout << "node [shape=\"box\"]" << std::endl; 
-    for (bb_info_collector bb : bbs) {
-        bb.print_graphviz();
+bool gimple_print_pass::gate(function *func) {
+    return (dump || !stats_path.empty()) && filter.matches(function_name(func));
+}
+
+static std::string function_output_path(function *func) {
+    if (output_dir.empty()) {
+        return "";
+    }
+    std::string name = IDENTIFIER_POINTER(DECL_ASSEMBLER_NAME(func->decl));
+    for (char &c : name) {
+        if (!ISALNUM(c) && c != '_' && c != '.' && c != '-') {
+            c = '_';
+        }
     }
-    std::cout << "}" << std::endl; 
+    return output_dir + "/" + name + ".dot";
+}
+
+static block_annotations annotate_block(basic_block bb, const dominator_tree &dom) {
+    block_annotations a = {-1, -1, 0, 0, 0};
+    if (bb->count.initialized_p()) {
+        a.count = bb->count.to_gcov_type();
+    }
+    a.idom = dom.get_idom(bb->index);
+    class loop *loop = bb->loop_father;
+    if (loop) {
+        a.loop_depth = loop_depth(loop);
+        if (loop->num != 0 && loop->header == bb) {
+            a.loop_flags |= BLOCK_LOOP_HEADER;
+        }
+        if (loop->num != 0 && loop->latch == bb) {
+            a.loop_flags |= BLOCK_LOOP_LATCH;
+        }
+    }
+    return a;
 }
 
 unsigned int gimple_print_pass::execute(function *func) {
+    if (!stats_path.empty()) {
+        stats.add_function(func);
+        return 0;
+    }
+
     basic_block bb;
     std::vector<bb_info_collector> bbs;
+    bbs.reserve(n_basic_blocks_for_fn(func));
+
+    // cfglib's dominator tree works on a copy of the CFG, so annotating
+    // leaves GCC's own dominance info as the previous pass left it.
+    std::unique_ptr<dominator_tree> dom;
+    if (annotate) {
+        dom.reset(new dominator_tree(cfg_graph_from_gcc(func)));
+    }
+    mark_dfs_back_edges();
     FOR_ALL_BB_FN(bb, func) {
         gimple_stmt_iterator it;
         bb_info_collector info(bb->index);
+        int cost = 0;
+        for (gphi_iterator phi = gsi_start_phis(bb); !gsi_end_p(phi); gsi_next(&phi)) {
+            if (!virtual_operand_p(gimple_phi_result(phi.phi()))) {
+                info.add_phi(phi.phi());
+            }
+        }
         for (it = gsi_start_bb(bb); !gsi_end_p(it); gsi_next(&it)) {
             gimple *stmt = gsi_stmt(it);
             info.add_statement(stmt);
+            if (annotate) {
+                cost += estimate_num_insns(stmt, &eni_time_weights);
+            }
+        }
+        if (annotate) {
+            block_annotations a = annotate_block(bb, *dom);
+            a.cost = cost;
+            info.set_annotations(a);
         }
 
         edge e;
         edge_iterator ei;
         FOR_EACH_EDGE(e, ei, bb->succs) {
-            info.add_adjacent(e->dest->index);
+            int probability = e->probability.initialized_p() ? e->probability.to_reg_br_prob_base() : -1;
+            info.add_adjacent(e->dest->index, e->flags, probability);
         }
-        bbs.push_back(info);
+        bbs.push_back(std::move(info));
+    }
+
+    write_job job;
+    job.function = function_name(func);
+    if (format == FORMAT_BIN) {
+        job.kind = write_job::BINARY_FUNCTION;
+    } else {
+        job.kind = write_job::GRAPHVIZ;
+        job.path = function_output_path(func);
     }
-    print_graphviz(bbs);
+    job.bbs = std::move(bbs);
+    writer.submit(std::move(job));
     return 0;
 }
 
+static std::string binary_output_path() {
+    std::string base = main_input_filename;
+    size_t slash = base.find_last_of('/');
+    if (slash != std::string::npos) {
+        base = base.substr(slash + 1);
+    }
+    if (output_path.empty()) {
+        return base + ".cfg";
+    }
+    if (output_path.back() == '/') {
+        return output_path + base + ".cfg";
+    }
+    return output_path;
+}
+
+static void start_unit(void *gcc_data, void *user_data) {
+    binary_writer.begin_unit(main_input_filename, compiler_version.c_str());
+}
+
+static void profile_pass(void *gcc_data, void *user_data) {
+    profiler.pass_started(((opt_pass *) gcc_data)->name, cfun);
+}
+
+static void profile_stop(void *gcc_data, void *user_data) {
+    profiler.stop();
+}
+
+static void finish(void *gcc_data, void *user_data) {
+    profiler.stop();
+    if (!stats_path.empty() && !stats.merge_into_file(stats_path.c_str(), main_input_filename)) {
+        error("gimple_print: cannot update statistics file %s", stats_path.c_str());
+    }
+    if (format == FORMAT_BIN) {
+        write_job job;
+        job.kind = write_job::BINARY_FILE;
+        job.path = binary_output_path();
+        writer.submit(std::move(job));
+    }
+    if (!stages.empty()) {
+        write_job job;
+        job.kind = write_job::TEXT;
+        job.path = stage_diff_path;
+        stages.render_diff(job.text);
+        writer.submit(std::move(job));
+    }
+    if (!lint_path.empty()) {
+        write_job job;
+        job.kind = write_job::APPEND_TEXT;
+        job.path = lint_path;
+        linter.render(job.text);
+        writer.submit(std::move(job));
+    }
+    if (!profile_path.empty()) {
+        write_job job;
+        job.kind = write_job::TEXT;
+        job.path = profile_path;
+        profiler.render_report(job.text, 50);
+        writer.submit(std::move(job));
+    }
+    if (!profile_trace_path.empty()) {
+        write_job job;
+        job.kind = write_job::TEXT;
+        job.path = profile_trace_path;
+        profiler.render_trace(job.text);
+        writer.submit(std::move(job));
+    }
+    if (!hot_report_path.empty()) {
+        write_job job;
+        job.kind = write_job::HOT_REPORT;
+        job.path = hot_report_path;
+        writer.submit(std::move(job));
+    }
+    for (const std::string &path : writer.finish()) {
+        error("gimple_print: cannot write %s", path.c_str());
+    }
+}
+
 static struct register_pass_info gimple_print_pass_info = {
     .pass = new gimple_print_pass(g),
     .reference_pass_name = "ssa",
@@ -66,9 +289,144 @@ static struct register_pass_info gimple_print_pass_info = {
     .pos_op = PASS_POS_INSERT_AFTER,
 };
 
+// Registered before gimple_print_pass at the same point, so the dump
+// shows the code without counters and both see the same bb->index.
+static struct register_pass_info bb_counter_pass_info = {
+    .pass = make_bb_counter_pass(g, &filter),
+    .reference_pass_name = "ssa",
+    .ref_pass_instance_number = 1,
+    .pos_op = PASS_POS_INSERT_AFTER,
+};
+
+// Registered last so it runs first: the dump and the counters see the
+// reduced code. Stays after ssa regardless of ref-pass.
+static struct register_pass_info mod_reduce_pass_info = {
+    .pass = make_mod_reduce_pass(g, &filter),
+    .reference_pass_name = "ssa",
+    .ref_pass_instance_number = 1,
+    .pos_op = PASS_POS_INSERT_AFTER,
+};
+
+static struct register_pass_info loop_lint_pass_info = {
+    .pass = make_loop_lint_pass(g, &linter, &filter),
+    .reference_pass_name = "ssa",
+    .ref_pass_instance_number = 1,
+    .pos_op = PASS_POS_INSERT_AFTER,
+};
+
+// One snapshot pass per stage, filled in by plugin_init.
+static std::vector<register_pass_info> stage_pass_info;
+
+static void parse_ref_pass(const char *value) {
+    const char *colon = strchr(value, ':');
+    ref_pass_name = colon ? std::string(value, colon - value) : std::string(value);
+    gimple_print_pass_info.reference_pass_name = ref_pass_name.c_str();
+    gimple_print_pass_info.ref_pass_instance_number = colon ? atoi(colon + 1) : 1;
+    bb_counter_pass_info.reference_pass_name = gimple_print_pass_info.reference_pass_name;
+    bb_counter_pass_info.ref_pass_instance_number = gimple_print_pass_info.ref_pass_instance_number;
+    loop_lint_pass_info.reference_pass_name = gimple_print_pass_info.reference_pass_name;
+    loop_lint_pass_info.ref_pass_instance_number = gimple_print_pass_info.ref_pass_instance_number;
+}
+
+static bool parse_arguments(struct plugin_name_args *args) {
+    bool dump_requested = false;
+    for (int i = 0; i < args->argc; ++i) {
+        const char *key = args->argv[i].key;
+        const char *value = args->argv[i].value ? args->argv[i].value : "";
+        if (!strcmp(key, "format") || !strcmp(key, "output") || !strcmp(key, "output-dir")) {
+            dump_requested = true;
+        }
+        if (!strcmp(key, "format")) {
+            if (!strcmp(value, "graphviz")) {
+                format = FORMAT_GRAPHVIZ;
+            } else if (!strcmp(value, "bin")) {
+                format = FORMAT_BIN;
+            } else {
+                error("gimple_print: unknown format %s", value);
+                return false;
+            }
+        } else if (!strcmp(key, "output")) {
+            output_path = value;
+        } else if (!strcmp(key, "function")) {
+            filter.add_names(value);
+        } else if (!strcmp(key, "function-regex")) {
+            if (!filter.add_pattern(value)) {
+                error("gimple_print: invalid regex %s", value);
+                return false;
+            }
+        } else if (!strcmp(key, "output-dir")) {
+            output_dir = value;
+        } else if (!strcmp(key, "annotate")) {
+            annotate = true;
+        } else if (!strcmp(key, "hot-report")) {
+            annotate = true;
+            hot_report_path = value;
+        } else if (!strcmp(key, "ref-pass")) {
+            parse_ref_pass(value);
+        } else if (!strcmp(key, "stats")) {
+            stats_path = value;
+        } else if (!strcmp(key, "instrument")) {
+            instrument = true;
+        } else if (!strcmp(key, "mod-reduce")) {
+            mod_reduce = true;
+        } else if (!strcmp(key, "stages")) {
+            if (!stages.add_stages(value)) {
+                error("gimple_print: invalid stage list %s", value);
+                return false;
+            }
+        } else if (!strcmp(key, "stage-diff")) {
+            stage_diff_path = value;
+        } else if (!strcmp(key, "profile")) {
+            profile_path = value;
+        } else if (!strcmp(key, "profile-trace")) {
+            profile_trace_path = value;
+        } else if (!strcmp(key, "lint")) {
+            lint_path = value;
+        } else {
+            error("gimple_print: unknown argument %s", key);
+            return false;
+        }
+    }
+    dump = !(instrument || mod_reduce || !stages.empty() || !lint_path.empty()) || dump_requested;
+    return true;
+}
+
 int plugin_init(struct plugin_name_args *args, struct plugin_gcc_version *version)
 {
+    if (!parse_arguments(args)) {
+        return 1;
+    }
+    compiler_version = std::string("gcc ") + version->basever;
+    writer.set_annotated(annotate);
     register_callback(args->base_name, PLUGIN_INFO, NULL, &gimple_print_info);
+    if (instrument) {
+        register_bb_counter_roots(args->base_name);
+        register_callback(args->base_name, PLUGIN_PASS_MANAGER_SETUP, NULL, &bb_counter_pass_info);
+    }
     register_callback(args->base_name, PLUGIN_PASS_MANAGER_SETUP, NULL, &gimple_print_pass_info);
+    if (!lint_path.empty()) {
+        register_callback(args->base_name, PLUGIN_PASS_MANAGER_SETUP, NULL, &loop_lint_pass_info);
+    }
+    if (mod_reduce) {
+        register_callback(args->base_name, PLUGIN_PASS_MANAGER_SETUP, NULL, &mod_reduce_pass_info);
+    }
+    const std::vector<stage_point> &points = stages.get_stages();
+    stage_pass_info.reserve(points.size());
+    for (size_t i = 0; i < points.size(); ++i) {
+        stage_pass_info.push_back({make_stage_pass(g, &stages, i, &filter), points[i].pass.c_str(), points[i].instance,
+                                   PASS_POS_INSERT_AFTER});
+        register_callback(args->base_name, PLUGIN_PASS_MANAGER_SETUP, NULL, &stage_pass_info.back());
+    }
+    if (!profile_path.empty() || !profile_trace_path.empty()) {
+        profiler.reserve(1 << 20);
+        register_callback(args->base_name, PLUGIN_PASS_EXECUTION, profile_pass, NULL);
+        register_callback(args->base_name, PLUGIN_EARLY_GIMPLE_PASSES_END, profile_stop, NULL);
+        register_callback(args->base_name, PLUGIN_ALL_IPA_PASSES_END, profile_stop, NULL);
+        register_callback(args->base_name, PLUGIN_ALL_PASSES_END, profile_stop, NULL);
+    }
+    if (format == FORMAT_BIN) {
+        register_callback(args->base_name, PLUGIN_START_UNIT, start_unit, NULL);
+    }
+    register_callback(args->base_name, PLUGIN_FINISH, finish, NULL);
     return 0;
 }
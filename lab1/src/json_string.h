@@ -0,0 +1,26 @@
+#ifndef JSON_STRING_H
+#define JSON_STRING_H
+
+#include <cstdio>
+#include <string>
+
+// Appends s as a quoted JSON string.
+inline void append_json_string(std::string &out, const char *s) {
+    out.append("\"");
+    for (; *s; ++s) {
+        unsigned char c = *s;
+        if (c == '"' || c == '\\') {
+            out.append("\\");
+            out.append(1, c);
+        } else if (c < 0x20) {
+            char buf[8];
+            snprintf(buf, sizeof(buf), "\\u%04x", c);
+            out.append(buf);
+        } else {
+            out.append(1, c);
+        }
+    }
+    out.append("\"");
+}
+
+#endif
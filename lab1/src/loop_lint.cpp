@@ -0,0 +1,375 @@
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "gcc-plugin.h"
+#include "tree.h"
+#include "tree-pass.h"
+#include "context.h"
+#include "gimple.h"
+#include "gimple-iterator.h"
+#include "cfgloop.h"
+#include "fold-const.h"
+#include "internal-fn.h"
+
+#include "loop_lint.h"
+#include "function_filter.h"
+#include "json_string.h"
+
+// Conditional branches with a known probability outside this range (out
+// of REG_BR_PROB_BASE) are considered predictable.
+static const int predictable_low = 1000;
+static const int predictable_high = 9000;
+
+struct loop_statements {
+    class loop *loop;
+    std::vector<gimple *> calls;
+    std::vector<gimple *> stores;
+    std::vector<gimple *> loads;
+    std::vector<gimple *> divisions;
+    std::vector<gimple *> branches;
+};
+
+struct hazard_reporter {
+    std::string &out;
+    function *func;
+    size_t count;
+
+    void report(const loop_statements &l, gimple *stmt, const char *hazard, const std::string &detail) {
+        location_t loc = gimple_location(stmt);
+        if (loc == UNKNOWN_LOCATION) {
+            loc = DECL_SOURCE_LOCATION(this->func->decl);
+        }
+        expanded_location xloc = expand_location(loc);
+        this->out.append("{\"unit\":");
+        append_json_string(this->out, main_input_filename);
+        this->out.append(",\"function\":");
+        append_json_string(this->out, function_name(this->func));
+        this->out.append(",\"loop\":" + std::to_string(l.loop->num));
+        this->out.append(",\"depth\":" + std::to_string(loop_depth(l.loop)));
+        this->out.append(",\"hazard\":");
+        append_json_string(this->out, hazard);
+        this->out.append(",\"detail\":");
+        append_json_string(this->out, detail.c_str());
+        this->out.append(",\"file\":");
+        append_json_string(this->out, xloc.file ? xloc.file : "");
+        this->out.append(",\"line\":" + std::to_string(xloc.line));
+        this->out.append(",\"column\":" + std::to_string(xloc.column) + "}\n");
+        this->count++;
+    }
+};
+
+static std::string tree_name(tree t) {
+    if (t && DECL_P(t) && DECL_NAME(t)) {
+        return IDENTIFIER_POINTER(DECL_NAME(t));
+    }
+    if (t && TREE_CODE(t) == SSA_NAME && SSA_NAME_IDENTIFIER(t)) {
+        return IDENTIFIER_POINTER(SSA_NAME_IDENTIFIER(t));
+    }
+    return "";
+}
+
+static std::string callee_name(gimple *stmt) {
+    if (gimple_call_internal_p(stmt)) {
+        return internal_fn_name(gimple_call_internal_fn(stmt));
+    }
+    tree decl = gimple_call_fndecl(stmt);
+    return decl ? tree_name(decl) : "<indirect>";
+}
+
+// The memory reference a statement stores to or loads from: an array
+// element, a dereference, or a field or bit-field of either (`a[i].f`,
+// `p->x`). Statements without virtual operands touch no memory.
+static tree memory_reference(gimple *stmt, bool store) {
+    if (!(store ? gimple_vdef(stmt) : gimple_vuse(stmt))) {
+        return NULL_TREE;
+    }
+    tree ref = store ? gimple_get_lhs(stmt) : gimple_assign_rhs1(stmt);
+    return ref && (handled_component_p(ref) || TREE_CODE(ref) == MEM_REF) ? ref : NULL_TREE;
+}
+
+static void collect_statement(loop_statements &l, gimple *stmt) {
+    switch (gimple_code(stmt)) {
+        case GIMPLE_CALL:
+            l.calls.push_back(stmt);
+            break;
+        case GIMPLE_ASSIGN:
+            switch (gimple_assign_rhs_code(stmt)) {
+                case TRUNC_DIV_EXPR:
+                case CEIL_DIV_EXPR:
+                case FLOOR_DIV_EXPR:
+                case ROUND_DIV_EXPR:
+                case TRUNC_MOD_EXPR:
+                case CEIL_MOD_EXPR:
+                case FLOOR_MOD_EXPR:
+                case ROUND_MOD_EXPR:
+                case RDIV_EXPR:
+                    if (TREE_CODE(gimple_assign_rhs2(stmt)) != INTEGER_CST
+                        && TREE_CODE(gimple_assign_rhs2(stmt)) != REAL_CST) {
+                        l.divisions.push_back(stmt);
+                    }
+                    break;
+                default:
+                    break;
+            }
+            if (memory_reference(stmt, true)) {
+                l.stores.push_back(stmt);
+            }
+            if (gimple_assign_single_p(stmt) && memory_reference(stmt, false)) {
+                l.loads.push_back(stmt);
+            }
+            break;
+        case GIMPLE_COND: {
+            basic_block bb = gimple_bb(stmt);
+            edge e;
+            edge_iterator ei;
+            bool exits = false;
+            bool biased = false;
+            FOR_EACH_EDGE(e, ei, bb->succs) {
+                exits |= loop_exit_edge_p(l.loop, e);
+                if (e->probability.initialized_p()) {
+                    int p = e->probability.to_reg_br_prob_base();
+                    biased |= p < predictable_low || p > predictable_high;
+                }
+            }
+            if (!exits && !biased) {
+                l.branches.push_back(stmt);
+            }
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+// A declaration whose address is never taken cannot be reached through
+// a pointer.
+static bool may_be_pointed_to(tree base) {
+    return !DECL_P(base) || TREE_ADDRESSABLE(base) || is_global_var(base);
+}
+
+// An array index as root + offset, following `x = y +- C` and conversions.
+// A constant index has a null root.
+struct affine_index {
+    tree root;
+    HOST_WIDE_INT offset;
+};
+
+static affine_index decompose_index(tree index) {
+    HOST_WIDE_INT offset = 0;
+    while (TREE_CODE(index) == SSA_NAME) {
+        gimple *def = SSA_NAME_DEF_STMT(index);
+        if (!is_gimple_assign(def)) {
+            break;
+        }
+        tree_code code = gimple_assign_rhs_code(def);
+        if (CONVERT_EXPR_CODE_P(code)) {
+            index = gimple_assign_rhs1(def);
+        } else if ((code == PLUS_EXPR || code == MINUS_EXPR) && tree_fits_shwi_p(gimple_assign_rhs2(def))) {
+            HOST_WIDE_INT c = tree_to_shwi(gimple_assign_rhs2(def));
+            offset += code == PLUS_EXPR ? c : -c;
+            index = gimple_assign_rhs1(def);
+        } else {
+            break;
+        }
+    }
+    if (tree_fits_shwi_p(index)) {
+        return {NULL_TREE, offset + tree_to_shwi(index)};
+    }
+    return {index, offset};
+}
+
+static bool loop_invariant(class loop *loop, tree root) {
+    if (TREE_CODE(root) != SSA_NAME) {
+        return true;
+    }
+    basic_block bb = gimple_bb(SSA_NAME_DEF_STMT(root));
+    return !bb || !flow_bb_inside_loop_p(loop, bb);
+}
+
+// Step of `root` if it is a header PHI `root = PHI<init, root + C>` of
+// loop, 0 otherwise.
+static HOST_WIDE_INT iv_step(class loop *loop, tree root) {
+    gimple *def = SSA_NAME_DEF_STMT(root);
+    if (gimple_code(def) != GIMPLE_PHI || gimple_bb(def) != loop->header || !loop->latch) {
+        return 0;
+    }
+    affine_index next = decompose_index(PHI_ARG_DEF_FROM_EDGE(as_a<gphi *>(def), loop_latch_edge(loop)));
+    return next.root == root ? next.offset : 0;
+}
+
+// How two accesses to the same array relate within loop, from the least
+// to the most severe; DISJOINT accesses never touch the same element.
+enum index_relation {
+    INDEX_SAME,     // the same element in every iteration
+    INDEX_CARRIED,  // the same element in iterations a fixed distance apart
+    INDEX_UNKNOWN,
+    INDEX_DISJOINT,
+};
+
+static index_relation compare_indices(class loop *loop, tree a, tree b) {
+    affine_index x = decompose_index(a);
+    affine_index y = decompose_index(b);
+    if (x.root != y.root) {
+        return INDEX_UNKNOWN;
+    }
+    if (x.offset == y.offset) {
+        return INDEX_SAME;
+    }
+    if (!x.root || loop_invariant(loop, x.root)) {
+        return INDEX_DISJOINT;
+    }
+    HOST_WIDE_INT step = iv_step(loop, x.root);
+    if (!step) {
+        return INDEX_UNKNOWN;
+    }
+    return (x.offset - y.offset) % step ? INDEX_DISJOINT : INDEX_CARRIED;
+}
+
+// Compares `a[i]...[j]` and `b[k]...[l]` dimension by dimension.
+static index_relation compare_array_refs(class loop *loop, tree a, tree b) {
+    index_relation result = INDEX_SAME;
+    while (TREE_CODE(a) == ARRAY_REF && TREE_CODE(b) == ARRAY_REF) {
+        index_relation r = compare_indices(loop, TREE_OPERAND(a, 1), TREE_OPERAND(b, 1));
+        if (r == INDEX_DISJOINT) {
+            return r;
+        }
+        result = std::max(result, r);
+        a = TREE_OPERAND(a, 0);
+        b = TREE_OPERAND(b, 0);
+    }
+    return operand_equal_p(a, b, 0) ? result : INDEX_UNKNOWN;
+}
+
+// The outermost array access of a reference, skipping the field,
+// bit-field and conversion selectors around it: `a[i]` for `a[i].f.g`.
+static tree strip_to_array_ref(tree ref) {
+    while (handled_component_p(ref) && TREE_CODE(ref) != ARRAY_REF) {
+        ref = TREE_OPERAND(ref, 0);
+    }
+    return ref;
+}
+
+// Returns the hazard kind if `store` and `other` may touch the same memory
+// in different iterations of loop, or null if they are independent or
+// identical. Only accesses to different declarations are known to be
+// independent; two accesses to one declaration are compared by index when
+// both are array elements, and reported otherwise.
+static const char *memory_hazard(class loop *loop, tree store, tree other) {
+    if (operand_equal_p(store, other, 0)) {
+        return nullptr;
+    }
+    tree base = get_base_address(store);
+    tree other_base = get_base_address(other);
+    if (!base || !other_base) {
+        return "pointer-alias";
+    }
+    if (DECL_P(base) && DECL_P(other_base)) {
+        if (base != other_base) {
+            return nullptr;
+        }
+        tree array = strip_to_array_ref(store);
+        tree other_array = strip_to_array_ref(other);
+        if (TREE_CODE(array) != ARRAY_REF || TREE_CODE(other_array) != ARRAY_REF) {
+            return "array-dependence";
+        }
+        index_relation r = compare_array_refs(loop, array, other_array);
+        return r == INDEX_CARRIED || r == INDEX_UNKNOWN ? "array-dependence" : nullptr;
+    }
+    if (!may_be_pointed_to(base) || !may_be_pointed_to(other_base)) {
+        return nullptr;
+    }
+    return "pointer-alias";
+}
+
+static void report_loop(hazard_reporter &reporter, const loop_statements &l) {
+    for (gimple *stmt : l.calls) {
+        reporter.report(l, stmt, "call", callee_name(stmt));
+    }
+    for (gimple *stmt : l.divisions) {
+        reporter.report(l, stmt, "variable-division", tree_name(gimple_assign_rhs2(stmt)));
+    }
+    // One report per store, naming the first conflicting access.
+    for (gimple *store : l.stores) {
+        tree ref = memory_reference(store, true);
+        const char *hazard = nullptr;
+        for (const std::vector<gimple *> *others : {&l.loads, &l.stores}) {
+            for (gimple *other : *others) {
+                if (other != store && !hazard) {
+                    hazard = memory_hazard(l.loop, ref, memory_reference(other, others == &l.stores));
+                }
+            }
+        }
+        if (hazard) {
+            reporter.report(l, store, hazard, tree_name(get_base_address(ref)));
+        }
+    }
+    if (l.branches.size() >= 2) {
+        reporter.report(l, l.branches.front(), "branch-chain",
+                        std::to_string(l.branches.size()) + " unbiased conditional branches");
+    }
+}
+
+void loop_linter::render(std::string &out) const {
+    out.append(this->output);
+    out.append("{\"unit\":");
+    append_json_string(out, main_input_filename);
+    out.append(",\"hazards\":" + std::to_string(this->hazards) + "}\n");
+}
+
+void loop_linter::lint_function(function *func) {
+    if (!loops_for_fn(func)) {
+        return;
+    }
+    std::map<int, loop_statements> loops;
+    basic_block bb;
+    FOR_EACH_BB_FN(bb, func) {
+        class loop *loop = bb->loop_father;
+        if (!loop || loop->num == 0) {
+            continue;
+        }
+        loop_statements &l = loops[loop->num];
+        l.loop = loop;
+        for (gimple_stmt_iterator it = gsi_start_bb(bb); !gsi_end_p(it); gsi_next(&it)) {
+            if (!is_gimple_debug(gsi_stmt(it))) {
+                collect_statement(l, gsi_stmt(it));
+            }
+        }
+    }
+    hazard_reporter reporter = {this->output, func, 0};
+    for (const auto &entry : loops) {
+        report_loop(reporter, entry.second);
+    }
+    this->hazards += reporter.count;
+}
+
+static struct pass_data loop_lint_pass_data = {
+    .type = GIMPLE_PASS,
+    .name = "loop_lint",
+    .properties_required = PROP_cfg | PROP_loops,
+};
+
+struct loop_lint_pass : gimple_opt_pass {
+    loop_linter *linter;
+    const function_filter *filter;
+
+    loop_lint_pass(gcc::context *ctx, loop_linter *linter, const function_filter *filter)
+        : gimple_opt_pass(loop_lint_pass_data, ctx), linter(linter), filter(filter) {}
+    virtual loop_lint_pass *clone() override { return this; }
+    virtual bool gate(function *func) override;
+    virtual unsigned int execute(function *func) override;
+};
+
+bool loop_lint_pass::gate(function *func) {
+    return this->filter->matches(function_name(func));
+}
+
+unsigned int loop_lint_pass::execute(function *func) {
+    this->linter->lint_function(func);
+    return 0;
+}
+
+gimple_opt_pass *make_loop_lint_pass(gcc::context *ctx, loop_linter *linter, const function_filter *filter) {
+    return new loop_lint_pass(ctx, linter, filter);
+}
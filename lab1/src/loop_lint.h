@@ -0,0 +1,44 @@
+#ifndef LOOP_LINT_H
+#define LOOP_LINT_H
+
+#include <string>
+
+#include "gcc-plugin.h"
+#include "tree-pass.h"
+
+class function_filter;
+
+// Reports loop performance hazards as JSON lines, one object per hazard:
+//   {"unit":..., "function":..., "loop":N, "depth":N, "hazard":KIND,
+//    "detail":..., "file":..., "line":N, "column":N}
+// KIND is one of
+//   call               a call in the loop body (detail = callee)
+//   array-dependence   a store and another access to the same declaration
+//                      whose indices reach the same element in different
+//                      iterations, or cannot be related (including accesses
+//                      that are not both array elements)
+//   pointer-alias      a store through a pointer and another access through
+//                      memory that it may alias
+//   variable-division  division or modulo by a non-constant
+//   branch-chain       two or more conditional branches in the body that do
+//                      not exit the loop and are not strongly biased
+// Memory accesses are array elements, dereferences, and fields of either.
+// Only statements of the innermost loop containing them are considered.
+// The unit ends with a summary line {"unit":..., "hazards":N}, so CI can
+// track the count per unit without parsing the hazards.
+class loop_linter {
+private:
+    std::string output;
+    size_t hazards;
+
+public:
+    loop_linter() : hazards(0) {}
+
+    void lint_function(function *func);
+    // Appends the hazards found so far and the summary line.
+    void render(std::string &out) const;
+};
+
+gimple_opt_pass *make_loop_lint_pass(gcc::context *ctx, loop_linter *linter, const function_filter *filter);
+
+#endif
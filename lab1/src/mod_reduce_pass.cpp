@@ -0,0 +1,155 @@
+#include <vector>
+
+#include "gcc-plugin.h"
+#include "tree.h"
+#include "tree-pass.h"
+#include "context.h"
+#include "gimple.h"
+#include "gimple-iterator.h"
+#include "ssa.h"
+#include "cfgloop.h"
+#include "fold-const.h"
+
+#include "mod_reduce_pass.h"
+#include "function_filter.h"
+
+static struct pass_data mod_reduce_pass_data = {
+    .type = GIMPLE_PASS,
+    .name = "mod_reduce",
+    .properties_required = PROP_cfg | PROP_ssa | PROP_loops,
+    .todo_flags_finish = TODO_update_ssa,
+};
+
+struct mod_reduce_pass : gimple_opt_pass {
+    const function_filter *filter;
+
+    mod_reduce_pass(gcc::context *ctx, const function_filter *filter)
+        : gimple_opt_pass(mod_reduce_pass_data, ctx), filter(filter) {}
+    virtual mod_reduce_pass *clone() override { return this; }
+    virtual bool gate(function *func) override;
+    virtual unsigned int execute(function *func) override;
+};
+
+bool mod_reduce_pass::gate(function *func) {
+    return this->filter->matches(function_name(func));
+}
+
+// A loop header PHI `iv = PHI<init (entry), iv + 1 (latch)>`.
+struct induction_variable {
+    tree iv;
+    tree init;
+    gimple *increment;
+    edge entry;
+    edge latch;
+};
+
+static bool match_induction_variable(class loop *loop, gphi *phi, induction_variable &result) {
+    tree iv = gimple_phi_result(phi);
+    tree type = TREE_TYPE(iv);
+    // Signed overflow is undefined, so iv never wraps and stays non-negative.
+    if (virtual_operand_p(iv) || !INTEGRAL_TYPE_P(type) || !TYPE_OVERFLOW_UNDEFINED(type)) {
+        return false;
+    }
+    edge latch = loop_latch_edge(loop);
+    edge entry = EDGE_PRED(loop->header, 0) == latch ? EDGE_PRED(loop->header, 1) : EDGE_PRED(loop->header, 0);
+    tree init = PHI_ARG_DEF_FROM_EDGE(phi, entry);
+    tree next = PHI_ARG_DEF_FROM_EDGE(phi, latch);
+    if (TREE_CODE(init) != INTEGER_CST || tree_int_cst_sgn(init) < 0 || TREE_CODE(next) != SSA_NAME) {
+        return false;
+    }
+    gimple *increment = SSA_NAME_DEF_STMT(next);
+    if (!is_gimple_assign(increment) || gimple_assign_rhs_code(increment) != PLUS_EXPR
+        || gimple_assign_rhs1(increment) != iv || !integer_onep(gimple_assign_rhs2(increment))) {
+        return false;
+    }
+    result = {iv, init, increment, entry, latch};
+    return true;
+}
+
+static bool is_reducible_mod(class loop *loop, gimple *stmt, tree iv) {
+    return is_gimple_assign(stmt) && gimple_assign_rhs_code(stmt) == TRUNC_MOD_EXPR
+        && gimple_assign_rhs1(stmt) == iv && TREE_CODE(gimple_assign_rhs2(stmt)) == INTEGER_CST
+        && tree_int_cst_sgn(gimple_assign_rhs2(stmt)) > 0
+        && flow_bb_inside_loop_p(loop, gimple_bb(stmt));
+}
+
+// Creates `r = PHI<init % C, r_next>` in the header and
+// `t = r + 1; c = t != C; r_next = c ? t : 0` after the increment of iv.
+static tree build_counter(const induction_variable &iv, tree modulus) {
+    tree type = TREE_TYPE(iv.iv);
+    tree r = make_temp_ssa_name(type, NULL, "mod_counter");
+    tree t = make_temp_ssa_name(type, NULL, "mod_counter");
+    tree c = make_temp_ssa_name(boolean_type_node, NULL, "mod_wrap");
+    tree r_next = make_temp_ssa_name(type, NULL, "mod_counter");
+
+    gimple_stmt_iterator gsi = gsi_for_stmt(iv.increment);
+    gsi_insert_after(&gsi, gimple_build_assign(t, PLUS_EXPR, r, build_int_cst(type, 1)), GSI_NEW_STMT);
+    gsi_insert_after(&gsi, gimple_build_assign(c, NE_EXPR, t, fold_convert(type, modulus)), GSI_NEW_STMT);
+    gsi_insert_after(&gsi, gimple_build_assign(r_next, COND_EXPR, c, t, build_zero_cst(type)), GSI_NEW_STMT);
+
+    gphi *phi = create_phi_node(r, iv.entry->dest);
+    tree init = fold_build2(TRUNC_MOD_EXPR, type, iv.init, fold_convert(type, modulus));
+    add_phi_arg(phi, init, iv.entry, UNKNOWN_LOCATION);
+    add_phi_arg(phi, r_next, iv.latch, UNKNOWN_LOCATION);
+    return r;
+}
+
+static void reduce_induction_variable(class loop *loop, const induction_variable &iv) {
+    std::vector<gimple *> uses;
+    use_operand_p use;
+    imm_use_iterator it;
+    FOR_EACH_IMM_USE_FAST(use, it, iv.iv) {
+        gimple *stmt = USE_STMT(use);
+        if (is_reducible_mod(loop, stmt, iv.iv)) {
+            uses.push_back(stmt);
+        }
+    }
+
+    // One counter per distinct modulus.
+    std::vector<std::pair<tree, tree>> counters;
+    for (gimple *stmt : uses) {
+        tree modulus = gimple_assign_rhs2(stmt);
+        tree counter = NULL_TREE;
+        for (const std::pair<tree, tree> &p : counters) {
+            if (tree_int_cst_equal(p.first, modulus)) {
+                counter = p.second;
+            }
+        }
+        if (!counter) {
+            counter = build_counter(iv, modulus);
+            counters.push_back({modulus, counter});
+        }
+        gimple_stmt_iterator gsi = gsi_for_stmt(stmt);
+        gimple_assign_set_rhs_from_tree(&gsi, counter);
+        update_stmt(gsi_stmt(gsi));
+    }
+}
+
+unsigned int mod_reduce_pass::execute(function *func) {
+    if (!loops_for_fn(func)) {
+        return 0;
+    }
+    basic_block bb;
+    FOR_EACH_BB_FN(bb, func) {
+        class loop *loop = bb->loop_father;
+        if (!loop || loop->num == 0 || loop->header != bb || !loop->latch || EDGE_COUNT(bb->preds) != 2) {
+            continue;
+        }
+        // Collect first: reducing adds PHIs to this block.
+        std::vector<induction_variable> ivs;
+        for (gphi_iterator it = gsi_start_phis(bb); !gsi_end_p(it); gsi_next(&it)) {
+            induction_variable iv;
+            if (match_induction_variable(loop, it.phi(), iv)) {
+                ivs.push_back(iv);
+            }
+        }
+        for (const induction_variable &iv : ivs) {
+            reduce_induction_variable(loop, iv);
+        }
+    }
+    return 0;
+}
+
+gimple_opt_pass *make_mod_reduce_pass(gcc::context *ctx, const function_filter *filter) {
+    return new mod_reduce_pass(ctx, filter);
+}
@@ -0,0 +1,14 @@
+#ifndef MOD_REDUCE_PASS_H
+#define MOD_REDUCE_PASS_H
+
+#include "gcc-plugin.h"
+#include "tree-pass.h"
+
+class function_filter;
+
+// Replaces `iv % C` inside a loop, where iv is a signed induction variable
+// starting at a non-negative constant with step 1 and C is a positive
+// constant, by a counter carried in a header PHI that wraps to 0 at C.
+gimple_opt_pass *make_mod_reduce_pass(gcc::context *ctx, const function_filter *filter);
+
+#endif
@@ -0,0 +1,160 @@
+#include <algorithm>
+#include <cstdio>
+#include <ctime>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "gcc-plugin.h"
+#include "tree.h"
+#include "function.h"
+#include "basic-block.h"
+#include "gimple.h"
+#include "gimple-iterator.h"
+#include "tree-pass.h"
+
+#include "pass_profiler.h"
+#include "json_string.h"
+
+static uint64_t now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+pass_profiler::pass_profiler() : dropped(0), open(false) {}
+
+void pass_profiler::reserve(size_t capacity) {
+    this->records.reserve(capacity);
+}
+
+uint32_t pass_profiler::function_id(function *func) {
+    if (!func || !func->decl) {
+        return UINT32_MAX;
+    }
+    auto it = this->function_ids.emplace(DECL_UID(func->decl), this->function_names.size());
+    if (it.second) {
+        this->function_names.push_back(function_name(func));
+    }
+    return it.first->second;
+}
+
+static uint32_t count_stmts(function *func) {
+    uint32_t stmts = 0;
+    basic_block bb;
+    FOR_EACH_BB_FN(bb, func) {
+        for (gimple_stmt_iterator it = gsi_start_bb(bb); !gsi_end_p(it); gsi_next(&it)) {
+            stmts++;
+        }
+    }
+    return stmts;
+}
+
+void pass_profiler::pass_started(const char *pass, function *func) {
+    this->stop();
+    if (this->records.size() == this->records.capacity()) {
+        this->dropped++;
+        return;
+    }
+    pass_record r = {pass, this->function_id(func), 0, 0, 0, 0};
+    // RTL shares the block storage with GIMPLE, so only walk statements
+    // while the function is still in GIMPLE form.
+    if (func && func->cfg) {
+        r.blocks = n_basic_blocks_for_fn(func);
+        if (!(func->curr_properties & PROP_rtl)) {
+            r.stmts = count_stmts(func);
+        }
+    }
+    // Counting is not part of the pass.
+    r.start = now();
+    this->records.push_back(r);
+    this->open = true;
+}
+
+void pass_profiler::stop() {
+    if (this->open) {
+        this->records.back().end = now();
+        this->open = false;
+    }
+}
+
+static std::string format_ms(uint64_t ns) {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%10.3f", ns / 1e6);
+    return buf;
+}
+
+void pass_profiler::render_report(std::string &out, size_t top) const {
+    struct total {
+        const char *pass;
+        uint32_t function;
+        uint64_t time;
+        uint32_t runs;
+        uint32_t blocks;
+        uint32_t stmts;
+    };
+    std::unordered_map<std::string, size_t> pair_index;
+    std::unordered_map<std::string, size_t> pass_index;
+    std::vector<total> pairs;
+    std::vector<total> passes;
+    uint64_t all = 0;
+    for (const pass_record &r : this->records) {
+        uint64_t time = r.end - r.start;
+        all += time;
+        std::string pass = r.pass ? r.pass : "<unnamed>";
+        auto p = pair_index.emplace(pass + '\0' + std::to_string(r.function), pairs.size());
+        if (p.second) {
+            pairs.push_back({r.pass, r.function, 0, 0, 0, 0});
+        }
+        total &pair = pairs[p.first->second];
+        pair.time += time;
+        pair.runs++;
+        pair.blocks = std::max(pair.blocks, r.blocks);
+        pair.stmts = std::max(pair.stmts, r.stmts);
+        auto q = pass_index.emplace(pass, passes.size());
+        if (q.second) {
+            passes.push_back({r.pass, UINT32_MAX, 0, 0, 0, 0});
+        }
+        passes[q.first->second].time += time;
+        passes[q.first->second].runs++;
+    }
+    auto by_time = [](const total &a, const total &b) { return a.time > b.time; };
+    std::sort(pairs.begin(), pairs.end(), by_time);
+    std::sort(passes.begin(), passes.end(), by_time);
+
+    out.append("# total " + format_ms(all) + " ms over " + std::to_string(this->records.size()) + " pass runs");
+    if (this->dropped) {
+        out.append(", " + std::to_string(this->dropped) + " runs dropped (buffer full)");
+    }
+    out.append("\n# ms runs blocks stmts pass function\n");
+    for (size_t i = 0; i < std::min(top, pairs.size()); ++i) {
+        const total &t = pairs[i];
+        out.append(format_ms(t.time) + " " + std::to_string(t.runs) + " " + std::to_string(t.blocks) + " "
+                   + std::to_string(t.stmts) + " " + (t.pass ? t.pass : "<unnamed>") + " "
+                   + (t.function == UINT32_MAX ? "<unit>" : this->function_names[t.function]) + "\n");
+    }
+    out.append("\n# ms runs pass\n");
+    for (size_t i = 0; i < std::min(top, passes.size()); ++i) {
+        const total &t = passes[i];
+        out.append(format_ms(t.time) + " " + std::to_string(t.runs) + " " + (t.pass ? t.pass : "<unnamed>") + "\n");
+    }
+}
+
+void pass_profiler::render_trace(std::string &out) const {
+    uint64_t origin = this->records.empty() ? 0 : this->records.front().start;
+    char buf[64];
+    out.append("{\"traceEvents\":[\n");
+    for (size_t i = 0; i < this->records.size(); ++i) {
+        const pass_record &r = this->records[i];
+        out.append("{\"name\":");
+        append_json_string(out, r.pass ? r.pass : "<unnamed>");
+        out.append(",\"cat\":\"pass\",\"ph\":\"X\",\"pid\":1,\"tid\":1");
+        snprintf(buf, sizeof(buf), ",\"ts\":%.3f,\"dur\":%.3f", (r.start - origin) / 1e3, (r.end - r.start) / 1e3);
+        out.append(buf);
+        out.append(",\"args\":{\"function\":");
+        append_json_string(out, r.function == UINT32_MAX ? "<unit>" : this->function_names[r.function].c_str());
+        out.append(",\"blocks\":" + std::to_string(r.blocks) + ",\"stmts\":" + std::to_string(r.stmts) + "}}");
+        out.append(i + 1 == this->records.size() ? "\n" : ",\n");
+    }
+    out.append("],\"displayTimeUnit\":\"ms\"}\n");
+}
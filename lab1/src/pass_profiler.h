@@ -0,0 +1,50 @@
+#ifndef PASS_PROFILER_H
+#define PASS_PROFILER_H
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "gcc-plugin.h"
+
+// One pass run on one function (or on the whole unit for IPA passes).
+struct pass_record {
+    const char *pass;   // opt_pass::name, static storage
+    uint32_t function;  // index into the function names, UINT32_MAX for none
+    uint32_t blocks;    // at pass start
+    uint32_t stmts;     // at pass start, GIMPLE passes only
+    uint64_t start;     // ns, CLOCK_MONOTONIC
+    uint64_t end;
+};
+
+// Times every pass x function pair. GCC only signals pass starts, so a
+// record is closed by the next PLUGIN_PASS_EXECUTION or by one of the
+// pipeline end events (see stop). Records go into a buffer preallocated
+// by reserve; runs past its capacity are counted but not kept. Statements
+// are counted at every GIMPLE pass start, before the clock starts, so the
+// walk adds to the compile time but not to the recorded pass times.
+class pass_profiler {
+private:
+    std::vector<pass_record> records;
+    std::vector<std::string> function_names;
+    std::unordered_map<unsigned int, uint32_t> function_ids;  // DECL_UID -> index in function_names
+    uint64_t dropped;
+    bool open;
+
+    uint32_t function_id(function *func);
+
+public:
+    pass_profiler();
+
+    void reserve(size_t capacity);
+    void pass_started(const char *pass, function *func);
+    void stop();
+
+    // Top pass x function pairs and top passes by total wall time.
+    void render_report(std::string &out, size_t top) const;
+    // Chrome trace-event JSON (chrome://tracing, Perfetto).
+    void render_trace(std::string &out) const;
+};
+
+#endif
@@ -0,0 +1,245 @@
+#include <algorithm>
+#include <cstdlib>
+#include <iterator>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "gcc-plugin.h"
+#include "tree.h"
+#include "tree-pass.h"
+#include "context.h"
+#include "gimple.h"
+#include "gimple-iterator.h"
+#include "cfgloop.h"
+
+#include "stage_tracker.h"
+#include "function_filter.h"
+
+bool stage_tracker::add_stages(const char *list) {
+    std::string value = list;
+    size_t start = 0;
+    while (start <= value.size()) {
+        size_t comma = value.find(',', start);
+        if (comma == std::string::npos) {
+            comma = value.size();
+        }
+        std::string label = value.substr(start, comma - start);
+        if (label.empty()) {
+            return false;
+        }
+        stage_point stage;
+        size_t colon = label.find(':');
+        stage.pass = label.substr(0, colon);
+        stage.instance = colon == std::string::npos ? 1 : atoi(label.c_str() + colon + 1);
+        stage.label = label;
+        stage.pass_name = "gimple_print_stage" + std::to_string(this->stages.size()) + "_" + stage.pass;
+        this->stages.push_back(stage);
+        start = comma + 1;
+    }
+    return true;
+}
+
+void stage_tracker::snapshot(int stage, function *func) {
+    auto it = this->function_ids.emplace(DECL_UID(func->decl), this->functions.size());
+    if (it.second) {
+        tracked_function function;
+        function.name = function_name(func);
+        function.assembler_name = IDENTIFIER_POINTER(DECL_ASSEMBLER_NAME(func->decl));
+        function.snapshots.resize(this->stages.size());
+        this->functions.push_back(std::move(function));
+    }
+    stage_snapshot &s = this->functions[it.first->second].snapshots[stage];
+    s = {true, 0, 0, 0, 0, 0, {}, {}};
+
+    basic_block bb;
+    FOR_EACH_BB_FN(bb, func) {
+        block_record block = {bb->index, {}, 0, -1};
+        edge e;
+        edge_iterator ei;
+        FOR_EACH_EDGE(e, ei, bb->succs) {
+            block.succs.push_back(e->dest->index);
+        }
+        s.edges += EDGE_COUNT(bb->succs);
+        for (gphi_iterator it = gsi_start_phis(bb); !gsi_end_p(it); gsi_next(&it)) {
+            s.phis++;
+        }
+        for (gimple_stmt_iterator it = gsi_start_bb(bb); !gsi_end_p(it); gsi_next(&it)) {
+            gimple *stmt = gsi_stmt(it);
+            if (is_gimple_debug(stmt)) {
+                continue;
+            }
+            s.stmts++;
+            block.stmts++;
+            if (is_gimple_call(stmt)) {
+                s.calls++;
+            } else if (is_gimple_assign(stmt) && VECTOR_TYPE_P(TREE_TYPE(gimple_assign_lhs(stmt)))) {
+                s.vector_stmts++;
+            }
+        }
+        class loop *loop = loops_for_fn(func) ? bb->loop_father : nullptr;
+        if (loop && loop->num != 0 && loop->header) {
+            block.loop = loop->header->index;
+            if (loop->header == bb) {
+                s.loops.push_back(bb->index);
+            }
+        }
+        s.blocks.push_back(std::move(block));
+    }
+    std::sort(s.blocks.begin(), s.blocks.end(),
+              [](const block_record &a, const block_record &b) { return a.index < b.index; });
+    std::sort(s.loops.begin(), s.loops.end());
+}
+
+static void append_count(std::string &out, const char *what, unsigned int before, unsigned int after) {
+    out.append(" ");
+    out.append(what);
+    out.append(" ");
+    out.append(std::to_string(after));
+    if (after != before) {
+        long long delta = (long long) after - before;
+        out.append(delta > 0 ? " (+" : " (");
+        out.append(std::to_string(delta));
+        out.append(")");
+    }
+}
+
+static void append_indices(std::string &out, const std::vector<int> &indices) {
+    for (int index : indices) {
+        out.append(" ");
+        out.append(std::to_string(index));
+    }
+}
+
+static void append_list(std::string &out, const char *what, const std::vector<int> &indices) {
+    if (indices.empty()) {
+        return;
+    }
+    out.append("    ");
+    out.append(what);
+    append_indices(out, indices);
+    out.append("\n");
+}
+
+static std::string loop_name(int header) {
+    return header < 0 ? "none" : "bb " + std::to_string(header);
+}
+
+// Lists the blocks only one of the snapshots has, and for blocks both have,
+// what changed about their successors, statements and loop.
+static void append_blocks(std::string &out, const stage_snapshot &p, const stage_snapshot &s) {
+    std::vector<int> removed, added;
+    std::string changed;
+    auto before = p.blocks.begin(), after = s.blocks.begin();
+    while (before != p.blocks.end() || after != s.blocks.end()) {
+        if (after == s.blocks.end() || (before != p.blocks.end() && before->index < after->index)) {
+            removed.push_back((before++)->index);
+        } else if (before == p.blocks.end() || after->index < before->index) {
+            added.push_back((after++)->index);
+        } else {
+            std::string change;
+            if (before->succs != after->succs) {
+                change.append(" succs");
+                append_indices(change, before->succs);
+                change.append(" ->");
+                append_indices(change, after->succs);
+            }
+            if (before->stmts != after->stmts) {
+                change.append(" stmts " + std::to_string(before->stmts) + " -> " + std::to_string(after->stmts));
+            }
+            if (before->loop != after->loop) {
+                change.append(" loop " + loop_name(before->loop) + " -> " + loop_name(after->loop));
+            }
+            if (!change.empty()) {
+                changed.append("    bb " + std::to_string(after->index) + ":" + change + "\n");
+            }
+            ++before;
+            ++after;
+        }
+    }
+    append_list(out, "blocks removed:", removed);
+    append_list(out, "blocks added:", added);
+    out.append(changed);
+}
+
+void stage_tracker::render_function(std::string &out, const tracked_function &function) const {
+    const std::vector<stage_snapshot> &snapshots = function.snapshots;
+    out.append(function.name);
+    if (function.assembler_name != function.name) {
+        out.append(" (" + function.assembler_name + ")");
+    }
+    out.append("\n");
+    const stage_snapshot *previous = nullptr;
+    for (size_t i = 0; i < this->stages.size(); ++i) {
+        const stage_snapshot &s = snapshots[i];
+        out.append("  ");
+        out.append(this->stages[i].label);
+        out.append(":");
+        if (!s.present) {
+            out.append(" not reached\n");
+            continue;
+        }
+        const stage_snapshot &p = previous ? *previous : s;
+        append_count(out, "blocks", p.blocks.size(), s.blocks.size());
+        append_count(out, "edges", p.edges, s.edges);
+        append_count(out, "stmts", p.stmts, s.stmts);
+        append_count(out, "phis", p.phis, s.phis);
+        append_count(out, "calls", p.calls, s.calls);
+        append_count(out, "loops", p.loops.size(), s.loops.size());
+        append_count(out, "vector", p.vector_stmts, s.vector_stmts);
+        out.append("\n");
+        if (previous) {
+            std::vector<int> removed, added;
+            std::set_difference(p.loops.begin(), p.loops.end(), s.loops.begin(), s.loops.end(),
+                                std::back_inserter(removed));
+            std::set_difference(s.loops.begin(), s.loops.end(), p.loops.begin(), p.loops.end(),
+                                std::back_inserter(added));
+            append_list(out, "loops removed (unrolled or eliminated), by header:", removed);
+            append_list(out, "loops added (versioned, peeled or epilogue), by header:", added);
+            if (s.vector_stmts > p.vector_stmts) {
+                out.append("    vectorized: " + std::to_string(s.vector_stmts - p.vector_stmts) + " new vector stmts\n");
+            }
+            if (s.stmts < p.stmts) {
+                out.append("    stmts eliminated: " + std::to_string(p.stmts - s.stmts) + "\n");
+            }
+            append_blocks(out, p, s);
+        }
+        previous = &s;
+    }
+}
+
+void stage_tracker::render_diff(std::string &out) const {
+    for (const tracked_function &function : this->functions) {
+        this->render_function(out, function);
+    }
+}
+
+struct stage_pass : gimple_opt_pass {
+    stage_tracker *tracker;
+    int stage;
+    const function_filter *filter;
+
+    stage_pass(gcc::context *ctx, const pass_data &data, stage_tracker *tracker, int stage,
+               const function_filter *filter)
+        : gimple_opt_pass(data, ctx), tracker(tracker), stage(stage), filter(filter) {}
+    virtual stage_pass *clone() override { return this; }
+    virtual bool gate(function *func) override;
+    virtual unsigned int execute(function *func) override;
+};
+
+bool stage_pass::gate(function *func) {
+    return this->filter->matches(function_name(func));
+}
+
+unsigned int stage_pass::execute(function *func) {
+    this->tracker->snapshot(this->stage, func);
+    return 0;
+}
+
+gimple_opt_pass *make_stage_pass(gcc::context *ctx, stage_tracker *tracker, int stage, const function_filter *filter) {
+    pass_data data = {};
+    data.type = GIMPLE_PASS;
+    data.name = tracker->get_stages()[stage].pass_name.c_str();
+    data.properties_required = PROP_cfg;
+    return new stage_pass(ctx, data, tracker, stage, filter);
+}
@@ -0,0 +1,76 @@
+#ifndef STAGE_TRACKER_H
+#define STAGE_TRACKER_H
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "gcc-plugin.h"
+#include "tree-pass.h"
+
+class function_filter;
+
+// One basic block of a snapshot. Blocks are matched across stages by
+// bb->index, which is stable while passes only add and remove blocks but
+// not when a pass compacts the CFG; a diff across such a pass shows the
+// renumbered blocks as changed.
+struct block_record {
+    int index;               // bb->index
+    std::vector<int> succs;  // bb->index of each successor, in edge order
+    unsigned int stmts;      // non-debug statements
+    int loop;                // header index of the innermost loop, -1 outside loops
+};
+
+// Counts and blocks of one function after one pipeline stage.
+struct stage_snapshot {
+    bool present;
+    unsigned int edges;
+    unsigned int stmts;
+    unsigned int phis;
+    unsigned int calls;
+    unsigned int vector_stmts;         // assignments with a vector result
+    std::vector<block_record> blocks;  // ascending index
+    std::vector<int> loops;            // header index of every loop, ascending;
+                                       // loop->num is reused across passes
+};
+
+// A pipeline point: after instance `instance` of GIMPLE pass `pass`.
+struct stage_point {
+    std::string pass;
+    int instance;
+    std::string label;      // as given in the stages argument
+    std::string pass_name;  // name of the snapshot pass, unique per stage
+};
+
+// A function seen by any stage, with one snapshot per stage.
+struct tracked_function {
+    std::string name;            // printable name
+    std::string assembler_name;  // tells apart clones, overloads and statics
+    std::vector<stage_snapshot> snapshots;
+};
+
+// Snapshots of every selected function at each stage, and the structural
+// diff between consecutive stages the function reached.
+class stage_tracker {
+private:
+    std::vector<stage_point> stages;
+    std::vector<tracked_function> functions;                // in order of first snapshot
+    std::unordered_map<unsigned int, size_t> function_ids;  // DECL_UID -> index in functions
+
+    void render_function(std::string &out, const tracked_function &function) const;
+
+public:
+    // Parses "NAME[:N],NAME[:N],...". Returns false on an empty entry.
+    bool add_stages(const char *list);
+    bool empty() const { return this->stages.empty(); }
+    const std::vector<stage_point> &get_stages() const { return this->stages; }
+
+    void snapshot(int stage, function *func);
+    void render_diff(std::string &out) const;
+};
+
+// Analysis pass that records a snapshot of each selected function for
+// stage `stage` of tracker. The tracker must not get new stages afterwards.
+gimple_opt_pass *make_stage_pass(gcc::context *ctx, stage_tracker *tracker, int stage, const function_filter *filter);
+
+#endif
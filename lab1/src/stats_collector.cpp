@@ -0,0 +1,167 @@
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+#include "gcc-plugin.h"
+#include "tree.h"
+#include "gimple.h"
+#include "gimple-iterator.h"
+#include "ssa.h"
+#include "stats_collector.h"
+
+stats_collector::stats_collector()
+    : gimple_code_counts(LAST_AND_UNUSED_GIMPLE_CODE), tree_code_counts(MAX_TREE_CODES),
+      functions(0), blocks(0), edges(0), stmts(0), phis(0), debug_stmts(0), virtual_phis(0),
+      blocks_histogram() {}
+
+static bool more_blocks(const stats_function &a, const stats_function &b) {
+    return a.blocks > b.blocks;
+}
+
+static void copy_name(char *dest, const char *src, size_t size) {
+    strncpy(dest, src ? src : "", size - 1);
+    dest[size - 1] = '\0';
+}
+
+void stats_collector::add_function(function *func) {
+    stats_function f = {};
+    copy_name(f.name, function_name(func), sizeof(f.name));
+
+    basic_block bb;
+    FOR_ALL_BB_FN(bb, func) {
+        f.blocks++;
+        f.edges += EDGE_COUNT(bb->succs);
+        // Debug statements and virtual PHIs are counted apart, so the
+        // totals of -g and non -g builds stay comparable.
+        for (gphi_iterator it = gsi_start_phis(bb); !gsi_end_p(it); gsi_next(&it)) {
+            if (virtual_operand_p(gimple_phi_result(it.phi()))) {
+                this->virtual_phis++;
+            } else {
+                f.phis++;
+            }
+        }
+        for (gimple_stmt_iterator it = gsi_start_bb(bb); !gsi_end_p(it); gsi_next(&it)) {
+            gimple *stmt = gsi_stmt(it);
+            if (is_gimple_debug(stmt)) {
+                this->debug_stmts++;
+                continue;
+            }
+            f.stmts++;
+            this->gimple_code_counts[gimple_code(stmt)]++;
+            if (gimple_code(stmt) == GIMPLE_ASSIGN) {
+                this->tree_code_counts[gimple_assign_rhs_code(stmt)]++;
+            } else if (gimple_code(stmt) == GIMPLE_COND) {
+                this->tree_code_counts[gimple_cond_code(stmt)]++;
+            }
+        }
+    }
+
+    this->functions++;
+    this->blocks += f.blocks;
+    this->edges += f.edges;
+    this->stmts += f.stmts;
+    this->phis += f.phis;
+    this->blocks_histogram[stats_histogram_bucket(f.blocks)]++;
+
+    // Only the largest functions can reach the shared table, so trim
+    // the local list whenever it doubles.
+    this->top_functions.push_back(f);
+    if (this->top_functions.size() >= 2 * STATS_TOP_FUNCTIONS) {
+        std::nth_element(this->top_functions.begin(), this->top_functions.begin() + STATS_TOP_FUNCTIONS,
+                         this->top_functions.end(), more_blocks);
+        this->top_functions.resize(STATS_TOP_FUNCTIONS);
+    }
+}
+
+void stats_collector::initialize_file(char *data) const {
+    stats_header *header = (stats_header *) data;
+    memcpy(header->magic, STATS_FORMAT_MAGIC, sizeof(header->magic));
+    header->version = STATS_FORMAT_VERSION;
+    header->num_gimple_codes = this->gimple_code_counts.size();
+    header->num_tree_codes = this->tree_code_counts.size();
+    char *names = data + sizeof(stats_header);
+    for (size_t i = 0; i < this->gimple_code_counts.size(); ++i, names += STATS_NAME_SIZE) {
+        copy_name(names, gimple_code_name[i], STATS_NAME_SIZE);
+    }
+    for (size_t i = 0; i < this->tree_code_counts.size(); ++i, names += STATS_NAME_SIZE) {
+        copy_name(names, get_tree_code_name((tree_code) i), STATS_NAME_SIZE);
+    }
+}
+
+void stats_collector::merge_into(char *data, const char *unit) {
+    stats_header *header = (stats_header *) data;
+    header->units++;
+    header->functions += this->functions;
+    header->blocks += this->blocks;
+    header->edges += this->edges;
+    header->stmts += this->stmts;
+    header->phis += this->phis;
+    header->debug_stmts += this->debug_stmts;
+    header->virtual_phis += this->virtual_phis;
+    for (int i = 0; i < STATS_HISTOGRAM_BUCKETS; ++i) {
+        header->blocks_histogram[i] += this->blocks_histogram[i];
+    }
+
+    uint64_t *counts = (uint64_t *) (data + sizeof(stats_header)
+                                     + (header->num_gimple_codes + header->num_tree_codes) * STATS_NAME_SIZE);
+    for (size_t i = 0; i < this->gimple_code_counts.size(); ++i) {
+        counts[i] += this->gimple_code_counts[i];
+    }
+    counts += header->num_gimple_codes;
+    for (size_t i = 0; i < this->tree_code_counts.size(); ++i) {
+        counts[i] += this->tree_code_counts[i];
+    }
+
+    std::vector<stats_function> top(header->top_functions, header->top_functions + header->num_top_functions);
+    for (stats_function f : this->top_functions) {
+        copy_name(f.unit, unit, sizeof(f.unit));
+        top.push_back(f);
+    }
+    std::stable_sort(top.begin(), top.end(), more_blocks);
+    header->num_top_functions = std::min<size_t>(top.size(), STATS_TOP_FUNCTIONS);
+    std::copy(top.begin(), top.begin() + header->num_top_functions, header->top_functions);
+}
+
+bool stats_collector::merge_into_file(const char *path, const char *unit) {
+    uint64_t size = stats_file_size(this->gimple_code_counts.size(), this->tree_code_counts.size());
+    int fd = open(path, O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+        return false;
+    }
+    // The lock serializes all compiler processes of the build, which keeps
+    // the top function table consistent as well as the counters.
+    struct stat st;
+    bool ok = flock(fd, LOCK_EX) == 0 && fstat(fd, &st) == 0;
+    bool fresh = ok && st.st_size == 0;
+    if (fresh) {
+        ok = ftruncate(fd, size) == 0;
+    } else if (ok) {
+        ok = (uint64_t) st.st_size == size;
+    }
+    void *map = ok ? mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+    if (map != MAP_FAILED) {
+        char *data = (char *) map;
+        const stats_header *header = (const stats_header *) data;
+        if (fresh) {
+            this->initialize_file(data);
+        }
+        ok = !memcmp(header->magic, STATS_FORMAT_MAGIC, sizeof(header->magic))
+            && header->version == STATS_FORMAT_VERSION
+            && header->num_gimple_codes == this->gimple_code_counts.size()
+            && header->num_tree_codes == this->tree_code_counts.size();
+        if (ok) {
+            this->merge_into(data, unit);
+        }
+        munmap(map, size);
+    } else {
+        ok = false;
+    }
+    flock(fd, LOCK_UN);
+    close(fd);
+    return ok;
+}
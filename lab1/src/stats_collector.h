@@ -0,0 +1,35 @@
+#ifndef STATS_COLLECTOR_H
+#define STATS_COLLECTOR_H
+
+#include <vector>
+
+#include "stats_format.h"
+#include "gcc-plugin.h"
+
+// Per-unit GIMPLE statistics, merged into the shared statistics file
+// (see stats_format.h) once the unit is compiled.
+class stats_collector {
+private:
+    std::vector<uint64_t> gimple_code_counts;
+    std::vector<uint64_t> tree_code_counts;
+    uint64_t functions;
+    uint64_t blocks;
+    uint64_t edges;
+    uint64_t stmts;
+    uint64_t phis;
+    uint64_t debug_stmts;
+    uint64_t virtual_phis;
+    uint64_t blocks_histogram[STATS_HISTOGRAM_BUCKETS];
+    std::vector<stats_function> top_functions;
+
+    void initialize_file(char *data) const;
+    void merge_into(char *data, const char *unit);
+
+public:
+    stats_collector();
+
+    void add_function(function *func);
+    bool merge_into_file(const char *path, const char *unit);
+};
+
+#endif
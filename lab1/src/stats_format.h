@@ -0,0 +1,61 @@
+#ifndef STATS_FORMAT_H
+#define STATS_FORMAT_H
+
+#include <cstdint>
+
+// Layout of the shared statistics file (`-fplugin-arg-gimple_print-stats=PATH`).
+// Every compiler process of a build merges its counters into the same file
+// under an exclusive flock. The file is a stats_header followed by
+//   char gimple_code_names[num_gimple_codes][STATS_NAME_SIZE]
+//   char tree_code_names[num_tree_codes][STATS_NAME_SIZE]
+//   uint64_t gimple_code_counts[num_gimple_codes]
+//   uint64_t tree_code_counts[num_tree_codes]
+// Code numbering depends on the GCC version, so the names are stored with
+// the counters and a process with different code counts does not merge.
+
+#define STATS_FORMAT_MAGIC "GPSTATS\0"
+#define STATS_FORMAT_VERSION 2
+#define STATS_NAME_SIZE 32
+#define STATS_HISTOGRAM_BUCKETS 32
+#define STATS_TOP_FUNCTIONS 64
+
+struct stats_function {
+    char name[96];
+    char unit[96];
+    uint64_t blocks;
+    uint64_t edges;
+    uint64_t stmts;
+    uint64_t phis;
+};
+
+struct stats_header {
+    char magic[8];
+    uint32_t version;
+    uint32_t num_gimple_codes;
+    uint32_t num_tree_codes;
+    uint32_t num_top_functions;
+    uint64_t units;
+    uint64_t functions;
+    uint64_t blocks;
+    uint64_t edges;
+    uint64_t stmts;         // without debug statements
+    uint64_t phis;          // without virtual PHIs
+    uint64_t debug_stmts;   // only present with -g
+    uint64_t virtual_phis;  // memory SSA PHIs
+    uint64_t blocks_histogram[STATS_HISTOGRAM_BUCKETS];  // bucket i: [2^i, 2^(i+1)) blocks
+    stats_function top_functions[STATS_TOP_FUNCTIONS];   // sorted by blocks, descending
+};
+
+inline uint64_t stats_file_size(uint32_t num_gimple_codes, uint32_t num_tree_codes) {
+    return sizeof(stats_header) + (uint64_t) (num_gimple_codes + num_tree_codes) * (STATS_NAME_SIZE + sizeof(uint64_t));
+}
+
+inline int stats_histogram_bucket(uint64_t value) {
+    int bucket = 0;
+    while (bucket + 1 < STATS_HISTOGRAM_BUCKETS && (2ull << bucket) <= value) {
+        ++bucket;
+    }
+    return bucket;
+}
+
+#endif
@@ -0,0 +1,104 @@
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "cfg_reader.h"
+#include "cfg_tables.h"
+
+// Combines binary CFG files from a whole build into one indexed file.
+// Usage: cfg_merge OUTPUT [INPUT...]; inputs are read from stdin if omitted.
+
+static void merge(cfg_tables &out, const cfg_file &in) {
+    uint32_t unit_base = out.units.size();
+    uint32_t function_base = out.functions.size();
+    uint32_t block_base = out.blocks.size();
+    uint32_t edge_base = out.edges.size();
+    uint32_t stmt_base = out.stmts.size();
+    uint32_t operand_base = out.operands.size();
+
+    std::unordered_map<uint32_t, uint32_t> string_ids;
+    auto remap = [&](uint32_t ref) {
+        if (ref == CFG_NO_STRING) {
+            return ref;
+        }
+        auto it = string_ids.find(ref);
+        if (it != string_ids.end()) {
+            return it->second;
+        }
+        const char *s = in.string(ref);
+        uint32_t id = s ? out.add_string(s) : CFG_NO_STRING;
+        string_ids.emplace(ref, id);
+        return id;
+    };
+
+    for (cfg_unit unit : in.units()) {
+        unit.name = remap(unit.name);
+        unit.compiler = remap(unit.compiler);
+        unit.first_function += function_base;
+        out.units.push_back(unit);
+    }
+    for (cfg_function function : in.functions()) {
+        function.name = remap(function.name);
+        function.unit += unit_base;
+        function.first_block += block_base;
+        out.functions.push_back(function);
+    }
+    for (cfg_block block : in.blocks()) {
+        block.function += function_base;
+        block.first_stmt += stmt_base;
+        block.first_edge += edge_base;
+        out.blocks.push_back(block);
+    }
+    for (cfg_edge e : in.edges()) {
+        e.src += block_base;
+        if (e.dest != UINT32_MAX) {
+            e.dest += block_base;
+        }
+        out.edges.push_back(e);
+    }
+    for (cfg_stmt stmt : in.stmts()) {
+        stmt.first_operand += operand_base;
+        out.stmts.push_back(stmt);
+    }
+    for (cfg_operand operand : in.operands()) {
+        operand.name = remap(operand.name);
+        out.operands.push_back(operand);
+    }
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        std::cerr << "usage: " << argv[0] << " OUTPUT [INPUT...]" << std::endl;
+        return 2;
+    }
+    std::vector<std::string> inputs(argv + 2, argv + argc);
+    if (inputs.empty()) {
+        std::string path;
+        while (std::getline(std::cin, path)) {
+            if (!path.empty()) {
+                inputs.push_back(path);
+            }
+        }
+    }
+
+    cfg_tables out;
+    int failed = 0;
+    for (const std::string &path : inputs) {
+        try {
+            cfg_file in(path.c_str());
+            merge(out, in);
+        } catch (const cfg_error &e) {
+            std::cerr << e.what() << std::endl;
+            ++failed;
+        }
+    }
+    if (!out.write(argv[1])) {
+        std::cerr << "cannot write " << argv[1] << std::endl;
+        return 1;
+    }
+    std::cerr << "merged " << inputs.size() - failed << " files, " << out.functions.size() << " functions, "
+              << out.blocks.size() << " blocks" << std::endl;
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,191 @@
+#include <cstring>
+#include <fcntl.h>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "cfg_reader.h"
+
+static const size_t section_record_size[CFG_SECTION_COUNT] = {
+    sizeof(char),
+    sizeof(cfg_unit),
+    sizeof(cfg_function),
+    sizeof(uint32_t),
+    sizeof(cfg_block),
+    sizeof(cfg_edge),
+    sizeof(cfg_stmt),
+    sizeof(cfg_operand),
+};
+
+cfg_file::cfg_file(const char *path) : fd(-1), data(nullptr), size(0) {
+    this->fd = open(path, O_RDONLY);
+    if (this->fd < 0) {
+        throw cfg_error(std::string("cannot open ") + path);
+    }
+    struct stat st;
+    if (fstat(this->fd, &st) < 0 || (size_t) st.st_size < sizeof(cfg_header)) {
+        close(this->fd);
+        throw cfg_error(std::string(path) + ": not a CFG file");
+    }
+    this->size = st.st_size;
+    void *map = mmap(nullptr, this->size, PROT_READ, MAP_SHARED, this->fd, 0);
+    if (map == MAP_FAILED) {
+        close(this->fd);
+        throw cfg_error(std::string("cannot mmap ") + path);
+    }
+    this->data = (const char *) map;
+
+    const cfg_header &h = this->header();
+    std::string error;
+    if (memcmp(h.magic, CFG_FORMAT_MAGIC, sizeof(h.magic))) {
+        error = "not a CFG file";
+    } else if (h.version != CFG_FORMAT_VERSION) {
+        error = "unsupported version " + std::to_string(h.version);
+    } else if (h.num_sections < CFG_SECTION_COUNT) {
+        error = "missing sections";
+    }
+    for (int i = 0; error.empty() && i < CFG_SECTION_COUNT; ++i) {
+        const cfg_section_entry &s = h.sections[i];
+        if (s.offset % 8 || s.offset > this->size || s.count > (this->size - s.offset) / section_record_size[i]) {
+            error = "truncated section " + std::to_string(i);
+        }
+    }
+    if (error.empty()) {
+        cfg_span<char> strings = this->section<char>(CFG_SECTION_STRINGS);
+        if (!strings.empty() && strings[strings.size - 1] != '\0') {
+            error = "unterminated string table";
+        }
+    }
+    if (!error.empty()) {
+        munmap((void *) this->data, this->size);
+        close(this->fd);
+        throw cfg_error(std::string(path) + ": " + error);
+    }
+    madvise((void *) this->data, this->size, MADV_WILLNEED);
+}
+
+cfg_file::cfg_file(cfg_file &&other) : fd(other.fd), data(other.data), size(other.size) {
+    other.fd = -1;
+    other.data = nullptr;
+    other.size = 0;
+}
+
+cfg_file::~cfg_file() {
+    if (this->data) {
+        munmap((void *) this->data, this->size);
+    }
+    if (this->fd >= 0) {
+        close(this->fd);
+    }
+}
+
+template <class T>
+cfg_span<T> cfg_file::section(cfg_section section) const {
+    const cfg_section_entry &s = this->header().sections[section];
+    return {(const T *) (this->data + s.offset), (size_t) s.count};
+}
+
+const cfg_header &cfg_file::header() const {
+    return *(const cfg_header *) this->data;
+}
+
+const char *cfg_file::string(uint32_t ref) const {
+    cfg_span<char> strings = this->section<char>(CFG_SECTION_STRINGS);
+    if (ref >= strings.size) {
+        return nullptr;
+    }
+    return strings.data + ref;
+}
+
+cfg_span<cfg_unit> cfg_file::units() const {
+    return this->section<cfg_unit>(CFG_SECTION_UNITS);
+}
+
+cfg_span<cfg_function> cfg_file::functions() const {
+    return this->section<cfg_function>(CFG_SECTION_FUNCTIONS);
+}
+
+cfg_span<uint32_t> cfg_file::function_index() const {
+    return this->section<uint32_t>(CFG_SECTION_FUNCTION_INDEX);
+}
+
+cfg_span<cfg_block> cfg_file::blocks() const {
+    return this->section<cfg_block>(CFG_SECTION_BLOCKS);
+}
+
+cfg_span<cfg_edge> cfg_file::edges() const {
+    return this->section<cfg_edge>(CFG_SECTION_EDGES);
+}
+
+cfg_span<cfg_stmt> cfg_file::stmts() const {
+    return this->section<cfg_stmt>(CFG_SECTION_STMTS);
+}
+
+cfg_span<cfg_operand> cfg_file::operands() const {
+    return this->section<cfg_operand>(CFG_SECTION_OPERANDS);
+}
+
+template <class T>
+static cfg_span<T> subspan(cfg_span<T> all, uint32_t first, uint32_t count) {
+    if (first > all.size || count > all.size - first) {
+        throw cfg_error("record range out of bounds");
+    }
+    return {all.data + first, count};
+}
+
+const cfg_unit &cfg_file::unit(const cfg_function &function) const {
+    cfg_span<cfg_unit> units = this->units();
+    if (function.unit >= units.size) {
+        throw cfg_error("unit index out of bounds");
+    }
+    return units[function.unit];
+}
+
+cfg_span<cfg_function> cfg_file::functions(const cfg_unit &unit) const {
+    return subspan(this->functions(), unit.first_function, unit.num_functions);
+}
+
+cfg_span<cfg_block> cfg_file::blocks(const cfg_function &function) const {
+    return subspan(this->blocks(), function.first_block, function.num_blocks);
+}
+
+cfg_span<cfg_edge> cfg_file::edges(const cfg_block &block) const {
+    return subspan(this->edges(), block.first_edge, block.num_edges);
+}
+
+cfg_span<cfg_stmt> cfg_file::stmts(const cfg_block &block) const {
+    return subspan(this->stmts(), block.first_stmt, block.num_stmts);
+}
+
+cfg_span<cfg_operand> cfg_file::operands(const cfg_stmt &stmt) const {
+    cfg_span<cfg_operand> all = this->operands();
+    if (stmt.first_operand > all.size) {
+        throw cfg_error("record range out of bounds");
+    }
+    // Operands are prefix-encoded, so only the start is known here.
+    return {all.data + stmt.first_operand, all.size - stmt.first_operand};
+}
+
+const cfg_function *cfg_file::find_function(const char *name) const {
+    cfg_span<uint32_t> index = this->function_index();
+    cfg_span<cfg_function> functions = this->functions();
+    size_t lo = 0, hi = index.size;
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        const char *s = index[mid] < functions.size ? this->string(functions[index[mid]].name) : nullptr;
+        if (s && strcmp(s, name) < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    if (lo < index.size && index[lo] < functions.size) {
+        const cfg_function &f = functions[index[lo]];
+        const char *s = this->string(f.name);
+        if (s && !strcmp(s, name)) {
+            return &f;
+        }
+    }
+    return nullptr;
+}
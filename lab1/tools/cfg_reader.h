@@ -0,0 +1,67 @@
+#ifndef CFG_READER_H
+#define CFG_READER_H
+
+#include <cstddef>
+#include <stdexcept>
+
+#include "cfg_format.h"
+
+template <class T>
+struct cfg_span {
+    const T *data;
+    size_t size;
+
+    const T *begin() const { return this->data; }
+    const T *end() const { return this->data + this->size; }
+    const T &operator[](size_t i) const { return this->data[i]; }
+    bool empty() const { return this->size == 0; }
+};
+
+class cfg_error : public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+};
+
+// Read-only view of a binary CFG file. The file is mmapped and its tables
+// are used in place, so opening costs the same regardless of file size.
+class cfg_file {
+private:
+    int fd;
+    const char *data;
+    size_t size;
+
+    template <class T>
+    cfg_span<T> section(cfg_section section) const;
+
+public:
+    explicit cfg_file(const char *path);
+    cfg_file(cfg_file &&other);
+    cfg_file(const cfg_file &) = delete;
+    cfg_file &operator=(const cfg_file &) = delete;
+    ~cfg_file();
+
+    const cfg_header &header() const;
+    // Null if ref is CFG_NO_STRING or out of bounds.
+    const char *string(uint32_t ref) const;
+
+    cfg_span<cfg_unit> units() const;
+    cfg_span<cfg_function> functions() const;
+    cfg_span<uint32_t> function_index() const;
+    cfg_span<cfg_block> blocks() const;
+    cfg_span<cfg_edge> edges() const;
+    cfg_span<cfg_stmt> stmts() const;
+    cfg_span<cfg_operand> operands() const;
+
+    // Throw cfg_error if the record refers outside its table.
+    const cfg_unit &unit(const cfg_function &function) const;
+    cfg_span<cfg_function> functions(const cfg_unit &unit) const;
+    cfg_span<cfg_block> blocks(const cfg_function &function) const;
+    cfg_span<cfg_edge> edges(const cfg_block &block) const;
+    cfg_span<cfg_stmt> stmts(const cfg_block &block) const;
+    cfg_span<cfg_operand> operands(const cfg_stmt &stmt) const;
+
+    // Binary search over the function index; returns null if absent.
+    const cfg_function *find_function(const char *name) const;
+};
+
+#endif
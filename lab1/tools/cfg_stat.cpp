@@ -0,0 +1,104 @@
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include "cfg_reader.h"
+
+// Prints totals, the blocks-per-function histogram and the largest
+// functions of one or more binary CFG files.
+// Usage: cfg_stat [-n TOP] [-f FUNCTION] FILE...
+
+struct function_size {
+    const cfg_file *file;
+    const cfg_function *function;
+};
+
+static const int histogram_buckets = 32;
+
+static const char *unit_name(const cfg_file &file, const cfg_function &f) {
+    const char *name = file.string(file.unit(f).name);
+    return name ? name : "?";
+}
+
+static int report(const std::vector<cfg_file> &files, size_t top, const char *lookup) {
+    size_t units = 0, blocks = 0, edges = 0, stmts = 0;
+    long long histogram[histogram_buckets] = {};
+    std::vector<function_size> functions;
+    for (const cfg_file &file : files) {
+        units += file.units().size;
+        blocks += file.blocks().size;
+        edges += file.edges().size;
+        stmts += file.stmts().size;
+        for (const cfg_function &f : file.functions()) {
+            int bucket = 0;
+            while (bucket + 1 < histogram_buckets && (1u << (bucket + 1)) <= f.num_blocks) {
+                ++bucket;
+            }
+            histogram[bucket]++;
+            functions.push_back({&file, &f});
+        }
+        if (lookup) {
+            const cfg_function *f = file.find_function(lookup);
+            if (f) {
+                const char *unit = unit_name(file, *f);
+                std::cout << lookup << " in " << unit << ": "
+                          << f->num_blocks << " blocks" << std::endl;
+            }
+        }
+    }
+
+    std::cout << "units " << units << "\nfunctions " << functions.size() << "\nblocks " << blocks
+              << "\nedges " << edges << "\nstatements " << stmts << "\n\nblocks per function:\n";
+    for (int i = 0; i < histogram_buckets; ++i) {
+        if (histogram[i]) {
+            std::cout << "  [" << (1ull << i) << ", " << (2ull << i) << ") " << histogram[i] << "\n";
+        }
+    }
+
+    top = std::min(top, functions.size());
+    std::partial_sort(functions.begin(), functions.begin() + top, functions.end(),
+                      [](const function_size &a, const function_size &b) {
+                          return a.function->num_blocks > b.function->num_blocks;
+                      });
+    std::cout << "\nlargest functions:\n";
+    for (size_t i = 0; i < top; ++i) {
+        const cfg_file &file = *functions[i].file;
+        const cfg_function &f = *functions[i].function;
+        const char *name = file.string(f.name);
+        const char *unit = unit_name(file, f);
+        std::cout << "  " << f.num_blocks << " " << (name ? name : "?") << " (" << unit << ")\n";
+    }
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    size_t top = 10;
+    const char *lookup = nullptr;
+    std::vector<cfg_file> files;
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "-n") && i + 1 < argc) {
+            top = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "-f") && i + 1 < argc) {
+            lookup = argv[++i];
+        } else {
+            try {
+                files.emplace_back(argv[i]);
+            } catch (const cfg_error &e) {
+                std::cerr << e.what() << std::endl;
+                return 1;
+            }
+        }
+    }
+    if (files.empty()) {
+        std::cerr << "usage: " << argv[0] << " [-n TOP] [-f FUNCTION] FILE..." << std::endl;
+        return 2;
+    }
+    try {
+        return report(files, top, lookup);
+    } catch (const cfg_error &e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+}
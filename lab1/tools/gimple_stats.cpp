@@ -0,0 +1,109 @@
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+#include "stats_format.h"
+
+// Prints the shared statistics file written by the plugin's stats mode.
+// Usage: gimple_stats [-n TOP] FILE
+
+struct code_count {
+    const char *name;
+    uint64_t count;
+};
+
+static void print_histogram(const char *title, std::vector<code_count> counts, size_t top) {
+    std::sort(counts.begin(), counts.end(), [](const code_count &a, const code_count &b) {
+        return a.count > b.count;
+    });
+    uint64_t total = 0;
+    for (const code_count &c : counts) {
+        total += c.count;
+    }
+    std::cout << "\n" << title << " (" << total << "):\n";
+    uint64_t max = counts.empty() ? 0 : counts[0].count;
+    for (size_t i = 0; i < counts.size() && i < top && counts[i].count; ++i) {
+        int width = max ? (int) (40 * counts[i].count / max) : 0;
+        std::cout << "  " << std::left << std::setw(STATS_NAME_SIZE) << counts[i].name << std::right
+                  << std::setw(12) << counts[i].count << std::setw(7) << std::fixed << std::setprecision(2)
+                  << 100.0 * counts[i].count / total << "% " << std::string(width, '#') << "\n";
+    }
+}
+
+int main(int argc, char **argv) {
+    size_t top = 20;
+    const char *path = nullptr;
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "-n") && i + 1 < argc) {
+            top = atoi(argv[++i]);
+        } else {
+            path = argv[i];
+        }
+    }
+    if (!path) {
+        std::cerr << "usage: " << argv[0] << " [-n TOP] FILE" << std::endl;
+        return 2;
+    }
+
+    int fd = open(path, O_RDONLY);
+    struct stat st;
+    if (fd < 0 || flock(fd, LOCK_SH) < 0 || fstat(fd, &st) < 0 || (size_t) st.st_size < sizeof(stats_header)) {
+        std::cerr << "cannot read " << path << std::endl;
+        return 1;
+    }
+    void *map = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED) {
+        std::cerr << "cannot mmap " << path << std::endl;
+        return 1;
+    }
+    const char *data = (const char *) map;
+    const stats_header &h = *(const stats_header *) data;
+    if (memcmp(h.magic, STATS_FORMAT_MAGIC, sizeof(h.magic)) || h.version != STATS_FORMAT_VERSION
+        || (uint64_t) st.st_size != stats_file_size(h.num_gimple_codes, h.num_tree_codes)) {
+        std::cerr << path << ": not a statistics file" << std::endl;
+        return 1;
+    }
+
+    std::cout << "units " << h.units << "\nfunctions " << h.functions << "\nblocks " << h.blocks
+              << "\nedges " << h.edges << "\nstatements " << h.stmts << "\nphis " << h.phis
+              << "\ndebug statements " << h.debug_stmts << "\nvirtual phis " << h.virtual_phis << "\n";
+
+    const char *names = data + sizeof(stats_header);
+    const uint64_t *counts = (const uint64_t *) (names + (h.num_gimple_codes + h.num_tree_codes) * STATS_NAME_SIZE);
+    std::vector<code_count> gimple_codes, tree_codes;
+    for (uint32_t i = 0; i < h.num_gimple_codes; ++i) {
+        gimple_codes.push_back({names + i * STATS_NAME_SIZE, counts[i]});
+    }
+    for (uint32_t i = 0; i < h.num_tree_codes; ++i) {
+        tree_codes.push_back({names + (h.num_gimple_codes + i) * STATS_NAME_SIZE, counts[h.num_gimple_codes + i]});
+    }
+    print_histogram("statements by gimple_code", gimple_codes, top);
+    print_histogram("operators by tree_code", tree_codes, top);
+
+    std::cout << "\nblocks per function:\n";
+    for (int i = 0; i < STATS_HISTOGRAM_BUCKETS; ++i) {
+        if (h.blocks_histogram[i]) {
+            std::cout << "  [" << (1ull << i) << ", " << (2ull << i) << ") " << h.blocks_histogram[i] << "\n";
+        }
+    }
+
+    std::cout << "\nlargest functions:\n";
+    for (uint32_t i = 0; i < h.num_top_functions && i < top; ++i) {
+        const stats_function &f = h.top_functions[i];
+        std::cout << "  " << f.blocks << " blocks, " << f.edges << " edges, " << f.stmts << " statements, "
+                  << f.phis << " phis  " << f.name << " (" << f.unit << ")\n";
+    }
+
+    munmap(map, st.st_size);
+    close(fd);
+    return 0;
+}
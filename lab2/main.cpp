@@ -1,6 +1,48 @@
+#include <llvm/AsmParser/Parser.h>
+#include <llvm/Bitcode/BitcodeReader.h>
+#include <llvm/Bitcode/BitcodeWriter.h>
 #include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/Verifier.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/SourceMgr.h>
+#include <llvm/Support/raw_ostream.h>
 
-int main() {
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <malloc.h>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+// Without arguments: prints the `353 + 48` module, as before.
+// With arguments: a stress benchmark that builds modules of N functions x
+// M blocks x K instructions through IRBuilder on T threads (one
+// LLVMContext and module per thread) and times each stage separately:
+// build, verify, print (textual IR), bitcode (write), parse-text and
+// parse-bitcode. Threads run each stage in lockstep, so a stage's wall
+// time and memory cover all threads. heap_delta_kb is the growth of live
+// malloc memory (all arenas plus mmap'd chunks) over the stage and
+// rss_delta_kb that of RSS, both taken while everything the stage produced
+// is still alive. RSS misses memory reused from earlier stages; the heap
+// figure counts it, but misses memory mapped outside malloc and counts
+// malloc's per-chunk overhead. peak_rss_delta_kb
+// is the stage's peak RSS above its starting RSS (-1 if
+// /proc/self/clear_refs cannot reset the peak). Modules that later stages
+// no longer need are freed between stages, outside the measurements.
+// Every combination of the comma-separated lists is run and written as CSV.
+//
+// Usage: main -n N[,N...] -m M[,M...] -k K[,K...] [-t T[,T...]] [-r REPEATS] [-o FILE]
+
+static void printExample() {
     llvm::LLVMContext ctx;
     llvm::IRBuilder<> builder(ctx);
     llvm::Module *mod = new llvm::Module("top", ctx);
@@ -14,3 +56,367 @@ int main() {
     builder.CreateRet(retVal);
     mod->print(llvm::errs(), nullptr);
 }
+
+struct Config {
+    int functions;
+    int blocks;
+    int instructions;
+    int threads;
+};
+
+enum Stage {
+    BUILD,
+    VERIFY,
+    PRINT,
+    BITCODE,
+    PARSE_TEXT,
+    PARSE_BITCODE,
+    STAGE_COUNT,
+};
+
+static const char *stageNames[STAGE_COUNT] = {"build", "verify", "print", "bitcode", "parse-text", "parse-bitcode"};
+
+struct StageResult {
+    double wallMs;
+    long heapDeltaKb;
+    long rssDeltaKb;
+    long peakRssDeltaKb;  // peak RSS during the stage above its starting RSS, -1 if unknown
+    size_t bytes;         // output size summed over threads, if the stage produces any
+};
+
+// Each function is `i32 fI(i32 a, i32 b)`: a chain of blocks, each with K
+// arithmetic instructions on a running value, that branches to the next
+// block or to an early exit; the last block returns the value.
+static std::unique_ptr<llvm::Module> buildModule(llvm::LLVMContext &ctx, const Config &config) {
+    auto mod = std::make_unique<llvm::Module>("stress", ctx);
+    llvm::IRBuilder<> builder(ctx);
+    llvm::Type *i32 = builder.getInt32Ty();
+    llvm::FunctionType *funcType = llvm::FunctionType::get(i32, {i32, i32}, false);
+    for (int f = 0; f < config.functions; ++f) {
+        llvm::Function *func = llvm::Function::Create(funcType, llvm::Function::ExternalLinkage,
+                                                      "f" + std::to_string(f), mod.get());
+        llvm::Value *a = func->getArg(0);
+        llvm::Value *b = func->getArg(1);
+        std::vector<llvm::BasicBlock *> blocks;
+        for (int i = 0; i < config.blocks; ++i) {
+            blocks.push_back(llvm::BasicBlock::Create(ctx, "bb" + std::to_string(i), func));
+        }
+        llvm::BasicBlock *exit = llvm::BasicBlock::Create(ctx, "exit", func);
+        builder.SetInsertPoint(exit);
+        builder.CreateRet(a);
+
+        llvm::Value *value = a;
+        for (int i = 0; i < config.blocks; ++i) {
+            builder.SetInsertPoint(blocks[i]);
+            for (int k = 0; k < config.instructions; ++k) {
+                llvm::Value *operand = k % 2 ? b : llvm::ConstantInt::get(i32, i * 31 + k + 1);
+                switch (k % 4) {
+                    case 0:
+                        value = builder.CreateAdd(value, operand);
+                        break;
+                    case 1:
+                        value = builder.CreateMul(value, operand);
+                        break;
+                    case 2:
+                        value = builder.CreateXor(value, operand);
+                        break;
+                    case 3:
+                        value = builder.CreateSub(value, operand);
+                        break;
+                }
+            }
+            if (i + 1 < config.blocks) {
+                llvm::Value *cond = builder.CreateICmpSGT(value, llvm::ConstantInt::get(i32, 0));
+                builder.CreateCondBr(cond, blocks[i + 1], exit);
+            } else {
+                builder.CreateRet(value);
+            }
+        }
+    }
+    return mod;
+}
+
+static long heapInUseKb() {
+    // uordblks covers the arenas; chunks large enough for their own mmap
+    // are only in hblkhd.
+    struct mallinfo2 info = mallinfo2();
+    return (info.uordblks + info.hblkhd) / 1024;
+}
+
+static long currentRssKb() {
+    long pages = 0;
+    FILE *statm = fopen("/proc/self/statm", "r");
+    if (statm) {
+        if (fscanf(statm, "%*s %ld", &pages) != 1) {
+            pages = 0;
+        }
+        fclose(statm);
+    }
+    return pages * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+// Resets the peak RSS (VmHWM) to the current RSS; false if unsupported.
+static bool resetPeakRss() {
+    FILE *clearRefs = fopen("/proc/self/clear_refs", "w");
+    if (!clearRefs) {
+        return false;
+    }
+    bool ok = fputs("5", clearRefs) >= 0;
+    return fclose(clearRefs) == 0 && ok;
+}
+
+static long peakRssKb() {
+    long kb = -1;
+    char line[256];
+    FILE *status = fopen("/proc/self/status", "r");
+    if (status) {
+        while (fgets(line, sizeof(line), status)) {
+            if (!strncmp(line, "VmHWM:", 6) && sscanf(line + 6, "%ld", &kb) != 1) {
+                kb = -1;
+            }
+        }
+        fclose(status);
+    }
+    return kb;
+}
+
+// Reusable barrier: the last thread to arrive runs `onComplete`.
+class Barrier {
+private:
+    std::mutex mutex;
+    std::condition_variable cv;
+    int count;
+    int waiting = 0;
+    int generation = 0;
+
+public:
+    explicit Barrier(int _count) : count(_count) {}
+
+    template <typename F> void wait(F onComplete) {
+        std::unique_lock<std::mutex> lock(mutex);
+        int gen = generation;
+        if (++waiting == count) {
+            onComplete();
+            waiting = 0;
+            generation++;
+            cv.notify_all();
+        } else {
+            cv.wait(lock, [&] { return gen != generation; });
+        }
+    }
+};
+
+struct Worker {
+    llvm::LLVMContext ctx;
+    std::unique_ptr<llvm::Module> module;
+    std::unique_ptr<llvm::Module> parsedText;
+    std::unique_ptr<llvm::Module> parsedBitcode;
+    std::string text;
+    std::string bitcode;
+    bool ok = true;
+};
+
+static void runStage(Worker &worker, Stage stage, const Config &config) {
+    switch (stage) {
+        case BUILD:
+            worker.module = buildModule(worker.ctx, config);
+            break;
+        case VERIFY:
+            worker.ok &= !llvm::verifyModule(*worker.module, &llvm::errs());
+            break;
+        case PRINT: {
+            llvm::raw_string_ostream out(worker.text);
+            worker.module->print(out, nullptr);
+            out.flush();
+            break;
+        }
+        case BITCODE: {
+            llvm::raw_string_ostream out(worker.bitcode);
+            llvm::WriteBitcodeToFile(*worker.module, out);
+            out.flush();
+            break;
+        }
+        case PARSE_TEXT: {
+            llvm::SMDiagnostic error;
+            worker.parsedText = llvm::parseAssemblyString(worker.text, error, worker.ctx);
+            worker.ok &= worker.parsedText != nullptr;
+            break;
+        }
+        case PARSE_BITCODE: {
+            llvm::MemoryBufferRef buffer(worker.bitcode, "stress.bc");
+            llvm::Expected<std::unique_ptr<llvm::Module>> parsed = llvm::parseBitcodeFile(buffer, worker.ctx);
+            if (parsed) {
+                worker.parsedBitcode = std::move(*parsed);
+            } else {
+                llvm::consumeError(parsed.takeError());
+                worker.ok = false;
+            }
+            break;
+        }
+        case STAGE_COUNT:
+            break;
+    }
+}
+
+static size_t stageBytes(const std::vector<std::unique_ptr<Worker>> &workers, Stage stage) {
+    size_t bytes = 0;
+    for (const auto &worker : workers) {
+        bytes += stage == PRINT ? worker->text.size() : stage == BITCODE ? worker->bitcode.size() : 0;
+    }
+    return bytes;
+}
+
+// Frees what no later stage needs once `stage` has been measured.
+static void releaseAfter(Worker &worker, Stage stage) {
+    if (stage == BITCODE) {
+        worker.module.reset();
+    } else if (stage == PARSE_TEXT) {
+        worker.parsedText.reset();
+    }
+}
+
+// Runs all stages once; false if a module failed to verify or parse.
+static bool runOnce(const Config &config, StageResult (&results)[STAGE_COUNT]) {
+    typedef std::chrono::steady_clock Clock;
+    std::vector<std::unique_ptr<Worker>> workers;
+    for (int t = 0; t < config.threads; ++t) {
+        workers.push_back(std::make_unique<Worker>());
+    }
+    Clock::time_point start;
+    long heapBefore = 0;
+    long rssBefore = 0;
+    bool peakReset = false;
+    Barrier barrier(config.threads);
+    auto body = [&](Worker &worker) {
+        for (int s = 0; s < STAGE_COUNT; ++s) {
+            Stage stage = (Stage) s;
+            barrier.wait([&] {
+                heapBefore = heapInUseKb();
+                rssBefore = currentRssKb();
+                peakReset = resetPeakRss();
+                start = Clock::now();
+            });
+            runStage(worker, stage, config);
+            barrier.wait([&] {
+                results[s].wallMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+                long peak = peakReset ? peakRssKb() : -1;
+                results[s].heapDeltaKb = heapInUseKb() - heapBefore;
+                results[s].rssDeltaKb = currentRssKb() - rssBefore;
+                results[s].peakRssDeltaKb = peak < 0 ? -1 : std::max(0L, peak - rssBefore);
+                results[s].bytes = stageBytes(workers, stage);
+            });
+            releaseAfter(worker, stage);
+        }
+    };
+    std::vector<std::thread> threads;
+    for (int t = 1; t < config.threads; ++t) {
+        threads.emplace_back(body, std::ref(*workers[t]));
+    }
+    body(*workers[0]);
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+    for (const auto &worker : workers) {
+        if (!worker->ok) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static std::vector<int> parseList(const char *arg) {
+    std::vector<int> values;
+    std::string list = arg;
+    size_t start = 0;
+    while (start <= list.size()) {
+        size_t comma = std::min(list.find(',', start), list.size());
+        int value = atoi(list.substr(start, comma - start).c_str());
+        if (value <= 0) {
+            return {};
+        }
+        values.push_back(value);
+        start = comma + 1;
+    }
+    return values;
+}
+
+static int usage(const char *name) {
+    std::cerr << "usage: " << name
+              << " -n N[,N...] -m M[,M...] -k K[,K...] [-t T[,T...]] [-r REPEATS] [-o FILE]" << std::endl;
+    return 2;
+}
+
+int main(int argc, char **argv) {
+    if (argc == 1) {
+        printExample();
+        return 0;
+    }
+
+    std::vector<int> functions = {100}, blocks = {10}, instructions = {10}, threads = {1};
+    int repeats = 1;
+    std::string outputPath;
+    for (int i = 1; i < argc; ++i) {
+        if (i + 1 >= argc) {
+            return usage(argv[0]);
+        }
+        const char *value = argv[++i];
+        if (!strcmp(argv[i - 1], "-n")) {
+            functions = parseList(value);
+        } else if (!strcmp(argv[i - 1], "-m")) {
+            blocks = parseList(value);
+        } else if (!strcmp(argv[i - 1], "-k")) {
+            instructions = parseList(value);
+        } else if (!strcmp(argv[i - 1], "-t")) {
+            threads = parseList(value);
+        } else if (!strcmp(argv[i - 1], "-r")) {
+            repeats = atoi(value);
+        } else if (!strcmp(argv[i - 1], "-o")) {
+            outputPath = value;
+        } else {
+            return usage(argv[0]);
+        }
+    }
+    if (functions.empty() || blocks.empty() || instructions.empty() || threads.empty() || repeats <= 0) {
+        return usage(argv[0]);
+    }
+
+    std::ofstream file;
+    if (!outputPath.empty()) {
+        file.open(outputPath);
+        if (!file) {
+            std::cerr << "cannot write " << outputPath << std::endl;
+            return 1;
+        }
+    }
+    std::ostream &out = outputPath.empty() ? std::cout : file;
+    out << "functions,blocks,instructions,threads,stage,wall_ms,heap_delta_kb,rss_delta_kb,peak_rss_delta_kb,bytes\n";
+    for (int n : functions) {
+        for (int m : blocks) {
+            for (int k : instructions) {
+                for (int t : threads) {
+                    Config config = {n, m, k, t};
+                    StageResult best[STAGE_COUNT];
+                    for (int r = 0; r < repeats; ++r) {
+                        StageResult results[STAGE_COUNT];
+                        if (!runOnce(config, results)) {
+                            std::cerr << "invalid module for n=" << n << " m=" << m << " k=" << k << std::endl;
+                            return 1;
+                        }
+                        for (int s = 0; s < STAGE_COUNT; ++s) {
+                            if (r == 0 || results[s].wallMs < best[s].wallMs) {
+                                best[s] = results[s];
+                            }
+                        }
+                    }
+                    for (int s = 0; s < STAGE_COUNT; ++s) {
+                        out << n << "," << m << "," << k << "," << t << "," << stageNames[s] << ","
+                            << best[s].wallMs << "," << best[s].heapDeltaKb << "," << best[s].rssDeltaKb << ","
+                            << best[s].peakRssDeltaKb << "," << best[s].bytes << "\n";
+                    }
+                    out.flush();
+                }
+            }
+        }
+    }
+    return 0;
+}